@@ -0,0 +1,155 @@
+// Build-time generator of the built-in bang table. Loads a bangs file in the upstream format with the server's own
+// parser, builds the table with the server's own hash and writes the result out as constant C++ data, which
+// embeddedBangTable() turns back into a table at startup without parsing or hashing anything.
+
+#include "include/bang.h"
+#include "include/embedded_bangs.h"
+#include "include/mapped_file.h"
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+namespace {
+    // A string_view initializer; bytes that are not plain printable ASCII become octal escapes, which unlike hex
+    // escapes end after three digits whatever follows
+    void writeString(std::ostream &out, const std::string_view value) {
+        out << "{\"";
+        for (const char c: value) {
+            const auto byte = static_cast<unsigned char>(c);
+            if (byte >= 0x20 && byte < 0x7F && c != '"' && c != '\\') {
+                out << c;
+            } else {
+                out << '\\' << static_cast<char>('0' + (byte >> 6)) << static_cast<char>('0' + ((byte >> 3) & 7))
+                        << static_cast<char>('0' + (byte & 7));
+            }
+        }
+        out << "\", " << value.size() << "}";
+    }
+
+    void writeOptionalString(std::ostream &out, const std::optional<std::string> &value) {
+        if (value) {
+            writeString(out, *value);
+        } else {
+            out << "{}";
+        }
+    }
+}
+
+void writeEmbeddedBangTable(std::ostream &out, const BangTable &table, const std::string_view source) {
+    if (table.size() == 0) {
+        // Arrays cannot be empty, and embeddedBangTable() takes a table without bangs for none at all
+        out << "// Generated by bangcodegen without any bangs; do not edit.\n"
+                << "#include \"embedded_bangs.h\"\n\n"
+                << "constinit const EmbeddedBangTable EMBEDDED_BANG_TABLE = {};\n";
+        return;
+    }
+
+    out << "// Generated by bangcodegen from " << source << "; do not edit.\n"
+            << "#include \"embedded_bangs.h\"\n\n"
+            << "namespace {\n";
+
+    out << "    constexpr uint64_t PILOTS[] = {\n" << std::hex;
+    for (const uint64_t pilot: table.m_pilots) {
+        out << "        0x" << pilot << "ULL,\n";
+    }
+    out << std::dec << "    };\n\n";
+
+    out << "    constexpr BangSlot SLOTS[] = {\n";
+    for (const BangSlot &slot: table.m_slots) {
+        out << "        {{";
+        for (size_t i = 0; i < sizeof(slot.bytes); ++i) {
+            out << (i ? ", " : "") << static_cast<unsigned>(slot.bytes[i]);
+        }
+        out << "}},\n";
+    }
+    out << "    };\n\n";
+
+    out << "    constexpr EmbeddedBang BANGS[] = {\n";
+    for (const Bang &bang: table.m_bangs) {
+        out << "        {";
+        writeString(out, bang.trigger);
+        out << ", ";
+        writeString(out, bang.url_template);
+        out << ", ";
+        writeOptionalString(out, bang.domain);
+        out << ", ";
+        writeOptionalString(out, bang.short_name);
+        out << ", ";
+        writeOptionalString(out, bang.subcategory);
+        out << ", ";
+        writeString(out, bang.redirect.head);
+        out << ", ";
+        writeString(out, bang.redirect.tail);
+        out << ", ";
+        writeOptionalString(out, bang.domainRedirect ? std::optional(bang.domainRedirect->head) : std::nullopt);
+        out << ", ";
+        writeOptionalString(out, bang.domainRedirect ? std::optional(bang.domainRedirect->tail) : std::nullopt);
+        out << ", " << bang.relevance.value_or(0) << "ULL, " << (bang.relevance ? "true" : "false") << ", "
+                << (bang.category ? static_cast<int>(*bang.category) : -1) << "},\n";
+    }
+    out << "    };\n"
+            << "}\n\n";
+
+    out << "constinit const EmbeddedBangTable EMBEDDED_BANG_TABLE = {\n"
+            << "    ";
+    writeString(out, source);
+    out << ",\n"
+            << "    " << table.m_seed << "ULL,\n"
+            << "    " << table.m_buckets << ",\n"
+            << "    " << table.m_denseBuckets << ",\n"
+            << "    " << table.m_maxRedirectSize << ",\n"
+            << "    PILOTS,\n"
+            << "    SLOTS,\n"
+            << "    BANGS,\n"
+            << "};\n";
+}
+
+// Writes source to output, or nothing at all if that fails
+bool writeSource(const std::string &output, const BangTable &table, const std::string_view source) {
+    std::ofstream out(output, std::ios::binary | std::ios::trunc);
+    writeEmbeddedBangTable(out, table, source);
+    if (!out.flush()) {
+        std::cerr << "Failed to write " << output << "\n";
+        std::filesystem::remove(output);
+        return false;
+    }
+    return true;
+}
+
+int main(const int argc, char *argv[]) {
+    if (argc != 3) {
+        std::cerr << "Usage: bangcodegen BANGS_JSON OUTPUT_CPP\n"
+                << "       bangcodegen --none OUTPUT_CPP   (build without any bangs)\n";
+        return 1;
+    }
+    const std::string input = argv[1];
+    const std::string output = argv[2];
+
+    if (input == "--none") {
+        if (!writeSource(output, BangTable(), "")) return 1;
+        std::cout << "Built no bangs into " << output << "\n";
+        return 0;
+    }
+
+    const MappedFile file(input, simdjson::SIMDJSON_PADDING);
+    if (!file.data() || file.size() == 0) {
+        std::cerr << "Cannot read bangs from " << input << "\n";
+        return 1;
+    }
+
+    absl::flat_hash_map<std::string, Bang> bangs;
+    const simdjson::padded_string_view json(file.data(), file.size(), file.size() + simdjson::SIMDJSON_PADDING);
+    if (parseBangData(json, bangs) <= 0) {
+        std::cerr << "No bangs in " << input << "\n";
+        return 1;
+    }
+
+    BangTable table;
+    table.build(bangs);
+    if (table.size() != bangs.size()) return 1;
+
+    if (!writeSource(output, table, std::filesystem::path(input).filename().string())) return 1;
+
+    std::cout << "Built " << table.size() << " bangs from " << input << " into " << output << "\n";
+    return 0;
+}
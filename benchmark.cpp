@@ -9,6 +9,10 @@
 #include <future>
 #include <atomic>
 #include <cerrno>
+#include <cstdlib>
+#include <new>
+#include <cstring>
+#include <ranges>
 
 #include <sys/socket.h>
 #include <netinet/in.h>
@@ -16,11 +20,70 @@
 #include <unistd.h>
 #include <arpa/inet.h>
 #include <sys/time.h>
+#include <sys/mman.h>
 
 #include "include/bang.h"
+#include "include/embedded_bangs.h"
 #include "include/memory_pool.h"
 #include "include/url_processing.h"
+#include "include/cpu_dispatch.h"
 #include "include/http_handler.h"
+#include "include/http_parser.h"
+
+// Counting allocator behind --check-allocs. Every replaceable form of operator new and delete is replaced, aligned
+// and nothrow ones included, so nothing reaches the library's allocator uncounted and each block is freed by the
+// allocator that made it. Counting is only switched on around the replay.
+static bool countAllocations = false;
+static size_t allocationCount = 0;
+
+static void *countedAllocate(const std::size_t size, const std::size_t alignment = alignof(std::max_align_t)) {
+    if (countAllocations) ++allocationCount;
+    if (alignment <= alignof(std::max_align_t)) return std::malloc(size ? size : 1);
+
+    void *ptr = nullptr;
+    return posix_memalign(&ptr, alignment, size ? size : 1) == 0 ? ptr : nullptr;
+}
+
+static void *countedAllocateOrThrow(const std::size_t size,
+                                    const std::size_t alignment = alignof(std::max_align_t)) {
+    if (void *ptr = countedAllocate(size, alignment)) return ptr;
+    throw std::bad_alloc();
+}
+
+void *operator new(const std::size_t size) { return countedAllocateOrThrow(size); }
+void *operator new[](const std::size_t size) { return countedAllocateOrThrow(size); }
+
+void *operator new(const std::size_t size, const std::align_val_t alignment) {
+    return countedAllocateOrThrow(size, static_cast<std::size_t>(alignment));
+}
+
+void *operator new[](const std::size_t size, const std::align_val_t alignment) {
+    return countedAllocateOrThrow(size, static_cast<std::size_t>(alignment));
+}
+
+void *operator new(const std::size_t size, const std::nothrow_t &) noexcept { return countedAllocate(size); }
+void *operator new[](const std::size_t size, const std::nothrow_t &) noexcept { return countedAllocate(size); }
+
+void *operator new(const std::size_t size, const std::align_val_t alignment, const std::nothrow_t &) noexcept {
+    return countedAllocate(size, static_cast<std::size_t>(alignment));
+}
+
+void *operator new[](const std::size_t size, const std::align_val_t alignment, const std::nothrow_t &) noexcept {
+    return countedAllocate(size, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete[](void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::size_t, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, std::size_t, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete(void *ptr, const std::nothrow_t &) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::align_val_t, const std::nothrow_t &) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, std::align_val_t, const std::nothrow_t &) noexcept { std::free(ptr); }
 
 std::string generateRandomQuery(const bool includeBang, std::mt19937 &rng) {
     static const std::vector<std::string> bangs = {
@@ -106,10 +169,10 @@ int createClientSocket(const std::string &serverAddress, int port) {
     return sockFd;
 }
 
-bool sendHttpRequest(const int sockFd, const std::string &url) {
+bool sendHttpRequest(const int sockFd, const std::string &url, const bool keepAlive = false) {
     const std::string request = "GET " + url + " HTTP/1.1\r\n"
                                 "Host: localhost\r\n"
-                                "Connection: close\r\n\r\n";
+                                + (keepAlive ? "Connection: keep-alive\r\n\r\n" : "Connection: close\r\n\r\n");
 
     const ssize_t sent = send(sockFd, request.c_str(), request.size(), 0);
     return sent == static_cast<ssize_t>(request.size());
@@ -167,8 +230,35 @@ void clientWorker(
     const std::string &serverAddress,
     const int port,
     std::atomic<int> &successCount,
-    std::atomic<int> &failCount
+    std::atomic<int> &failCount,
+    const bool keepAlive
 ) {
+    if (keepAlive) {
+        // One persistent connection per thread, so the run measures request handling rather than TCP setup
+        int sockFd = -1;
+        for (int i = startIdx; i < endIdx; ++i) {
+            if (sockFd < 0 && (sockFd = createClientSocket(serverAddress, port)) < 0) {
+                ++failCount;
+                continue;
+            }
+
+            std::string response;
+            if (sendHttpRequest(sockFd, urls[i], true)) {
+                response = receiveHttpResponse(sockFd);
+            }
+
+            if (response.empty() || response.find("HTTP/1.1 302") == std::string::npos) {
+                ++failCount;
+                close(sockFd);
+                sockFd = -1;
+            } else {
+                ++successCount;
+            }
+        }
+        if (sockFd >= 0) close(sockFd);
+        return;
+    }
+
     for (int i = startIdx; i < endIdx; ++i) {
         const int sockFd = createClientSocket(serverAddress, port);
         if (sockFd < 0) {
@@ -194,7 +284,7 @@ void clientWorker(
 }
 
 void runNetworkBenchmark(const std::vector<std::string> &allTestUrls, const std::string &serverAddress, int port,
-                         int numThreads = -1) {
+                         int numThreads = -1, const bool keepAlive = false) {
     std::vector<std::string> testUrls;
 
     if (constexpr size_t networkQueryCount = 10000; allTestUrls.size() > networkQueryCount) {
@@ -219,7 +309,7 @@ void runNetworkBenchmark(const std::vector<std::string> &allTestUrls, const std:
         numThreads = 1;
     }
 
-    std::cout << "Using " << numThreads << " threads for benchmark" << std::endl;
+    std::cout << "Using " << numThreads << " threads for benchmark" << (keepAlive ? " (keep-alive)" : "") << std::endl;
 
     constexpr int numRuns = 3;
     constexpr int warmupRuns = 1;
@@ -248,7 +338,8 @@ void runNetworkBenchmark(const std::vector<std::string> &allTestUrls, const std:
                                  std::ref(serverAddress),
                                  port,
                                  std::ref(successCount),
-                                 std::ref(failCount));
+                                 std::ref(failCount),
+                                 keepAlive);
         }
 
         for (auto &thread: threads) {
@@ -285,20 +376,15 @@ void processUrlBatch(
     const size_t startIdx,
     const size_t endIdx
 ) {
-    char *decodeBuffer = getRequestPool().acquire();
-    char *encodeBuffer = getEncodePool().acquire();
     char *responseBuffer = getRedirectPool().acquire();
 
     for (size_t i = startIdx; i < endIdx; ++i) {
-        auto [searchUrl, encodedQuery] = processQuery(urls[i], decodeBuffer, encodeBuffer);
         // Prevent optimization
-        if (auto response = createRedirectResponse(searchUrl, encodedQuery, responseBuffer); response.empty()) {
+        if (renderQueryResponse(urls[i], responseBuffer) == 0) {
             std::cerr << "Error: empty response\n";
         }
     }
 
-    getRequestPool().release(decodeBuffer);
-    getEncodePool().release(encodeBuffer);
     getRedirectPool().release(responseBuffer);
 }
 
@@ -317,22 +403,17 @@ void runInProcessBenchmark(const std::vector<std::string> &testUrls, int numThre
 
     // Warm-up phase
     std::cout << "Running warmup..." << std::endl;
-    char *decodeBuffer = getRequestPool().acquire();
-    char *encodeBuffer = getEncodePool().acquire();
     char *responseBuffer = getRedirectPool().acquire();
 
     for (int i = 0; i < 1; ++i) {
         for (const auto &url: testUrls) {
-            auto [searchUrl, encodedQuery] = processQuery(url, decodeBuffer, encodeBuffer);
             // Prevent optimization
-            if (auto response = createRedirectResponse(searchUrl, encodedQuery, responseBuffer); response.empty()) {
+            if (renderQueryResponse(url, responseBuffer) == 0) {
                 std::cerr << "Error: empty response\n";
             }
         }
     }
 
-    getRequestPool().release(decodeBuffer);
-    getEncodePool().release(encodeBuffer);
     getRedirectPool().release(responseBuffer);
 
     // Benchmark phase
@@ -345,21 +426,15 @@ void runInProcessBenchmark(const std::vector<std::string> &testUrls, int numThre
         auto start = std::chrono::high_resolution_clock::now();
 
         if (numThreads == 1) {
-            char *tDecodeBuffer = getRequestPool().acquire();
-            char *tEncodeBuffer = getEncodePool().acquire();
             char *tResponseBuffer = getRedirectPool().acquire();
 
             for (const auto &url: testUrls) {
-                auto [searchUrl, encodedQuery] = processQuery(url, tDecodeBuffer, tEncodeBuffer);
                 // Prevent optimization
-                if (auto response = createRedirectResponse(searchUrl, encodedQuery, tResponseBuffer); response.
-                    empty()) {
+                if (renderQueryResponse(url, tResponseBuffer) == 0) {
                     std::cerr << "Error: empty response\n";
                 }
             }
 
-            getRequestPool().release(tDecodeBuffer);
-            getEncodePool().release(tEncodeBuffer);
             getRedirectPool().release(tResponseBuffer);
         } else {
             std::vector<std::thread> threads;
@@ -398,14 +473,397 @@ void runInProcessBenchmark(const std::vector<std::string> &testUrls, int numThre
     std::cout << "Average time per query: " << avgQueryTimeUs << " µs" << std::endl;
 }
 
-int main(const int argc, char *argv[]) {
-    std::cout << "Loading bang data from bang.json..." << std::endl;
-    if (!loadBangDataFromUrl("https://duckduckgo.com/bang.js")) {
-        std::cerr << "Failed to load bang data from API\n";
+// Serves one request the way the server does: parse, pick the response, render it. Returns the response size.
+size_t serveRequest(const std::string_view request, char *responseBuffer) {
+    HttpRequest parsed;
+    if (parseHttpRequest(request, parsed) == std::string_view::npos) return 0;
+
+    const bool keepAlive = isKeepAlive(parsed);
+    if (parsed.path == "/opensearch.xml") {
+        return createHttpResponse(HttpStatus::OK, CONTENT_TYPE_XML, OPENSEARCH_XML, responseBuffer, keepAlive).size();
+    }
+    if (parsed.path == "/" && !parsed.query.starts_with(QUERY_PARAM.substr(1))) {
+        return createHttpResponse(HttpStatus::OK, CONTENT_TYPE_HTML, HOME_PAGE_HTML, responseBuffer, keepAlive).size();
+    }
+
+    return renderSearchResponse(parsed.query, responseBuffer, keepAlive);
+}
+
+// Replays the query corpus through the whole request path with the counting allocator on, and fails if anything
+// on it touches the heap. Building the requests and the first, warming pass run with counting off.
+int runAllocationCheck(const std::vector<std::string> &testUrls) {
+    std::cout << "=============== ALLOCATION CHECK ===============" << std::endl;
+
+    std::vector<std::string> requests;
+    requests.reserve(testUrls.size() + 8);
+    for (const auto &url: testUrls) {
+        requests.push_back("GET " + url + " HTTP/1.1\r\nHost: localhost\r\nConnection: keep-alive\r\n\r\n");
+    }
+
+    // Shapes the generated corpus does not cover: mid-query and trailing bangs, bare bangs, non-search pages
+    const std::vector<std::string> extraUrls = {
+        "/search?q=rust+!gh+async", "/search?q=a+!notabangbutlongerthansso+b", "/search?q=caf%C3%A9+!w",
+        "/search?q=!gh", "/search?q=%21yt", "/?q=", "/", "/opensearch.xml", "/search?q=" + std::string(1000, 'x')
+    };
+    for (const auto &url: extraUrls) {
+        requests.push_back("GET " + url + " HTTP/1.0\r\nHost: localhost\r\n\r\n");
+    }
+
+    char *responseBuffer = getRedirectPool().acquire();
+
+    size_t failures = 0;
+    for (int pass = 0; pass < 2; ++pass) {
+        allocationCount = 0;
+        countAllocations = pass > 0;
+
+        for (const auto &request: requests) {
+            const size_t before = allocationCount;
+            if (serveRequest(request, responseBuffer) == 0) {
+                ++failures;
+            }
+
+            if (allocationCount != before && failures++ < 10) {
+                countAllocations = false;
+                std::cerr << "Heap allocation while serving: " << request.substr(0, request.find('\r')) << "\n";
+                countAllocations = true;
+            }
+        }
+        countAllocations = false;
+    }
+
+    getRedirectPool().release(responseBuffer);
+
+    std::cout << "Replayed " << requests.size() << " requests: " << allocationCount << " heap allocations" << std::endl;
+    if (failures > 0 || allocationCount > 0) {
+        std::cout << "FAILED" << std::endl;
+        return 1;
+    }
+    std::cout << "PASSED" << std::endl;
+    return 0;
+}
+
+// Bytes outside printable ASCII as \xNN, for reporting fuzz inputs
+std::string printable(const std::string_view text) {
+    std::string result;
+    for (const char c: text) {
+        if (c >= ' ' && c <= '~' && c != '\\') {
+            result += c;
+        } else {
+            result += "\\x";
+            result += "0123456789abcdef"[static_cast<unsigned char>(c) >> 4];
+            result += "0123456789abcdef"[c & 0xF];
+        }
+    }
+    return result;
+}
+
+// Plain byte-at-a-time versions of the search path, written from the rules rather than from the kernels, for
+// --fuzz to compare every SIMD tier against.
+
+// %XX (decoded through the perfect hex map, so with its & 0x1F quirk) when two more bytes follow the '%', '+' as a
+// space, everything else as it is
+std::string referenceDecode(const std::string_view text) {
+    const auto &hex = getHexTables().perfectHexMap;
+    std::string decoded;
+    for (size_t i = 0; i < text.size(); ++i) {
+        const unsigned char high = i + 2 < text.size() ? hex[static_cast<unsigned char>(text[i + 1]) & 0x1F] : 255;
+        const unsigned char low = i + 2 < text.size() ? hex[static_cast<unsigned char>(text[i + 2]) & 0x1F] : 255;
+        if (text[i] == '%' && high != 255 && low != 255) {
+            decoded += static_cast<char>(high << 4 | low);
+            i += 2;
+        } else {
+            decoded += text[i] == '+' ? ' ' : text[i];
+        }
+    }
+    return decoded;
+}
+
+// Letters, digits and "-_.~!" as they are, space as '+', every other byte as %XX
+std::string referenceEncode(const std::string_view text) {
+    std::string encoded;
+    for (const char c: text) {
+        if (c == ' ') {
+            encoded += '+';
+        } else if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+                   (c != '\0' && std::string_view("-_.~!").find(c) != std::string_view::npos)) {
+            encoded += c;
+        } else {
+            encoded += '%';
+            encoded += "0123456789ABCDEF"[static_cast<unsigned char>(c) >> 4];
+            encoded += "0123456789ABCDEF"[c & 0xF];
+        }
+    }
+    return encoded;
+}
+
+// Looked up in allBangs() rather than bangTable(), so the perfect hash gets checked along the way
+const Bang *referenceFindBang(const std::string_view trigger) {
+    if (trigger.size() < 2) return nullptr;
+    const absl::flat_hash_map<std::string, Bang> &bangs = allBangs();
+    const auto it = bangs.find(std::string(trigger));
+    return it != bangs.end() ? &it->second : nullptr;
+}
+
+// A bang is '!' up to the next space
+std::string_view bangTokenAt(const std::string_view text, const size_t position) {
+    return text.substr(position, text.find(' ', position) - position);
+}
+
+// First '!' at the start or after a space, with something after it, that starts a known bang
+size_t referenceBangPosition(const std::string_view text) {
+    for (size_t i = 0; i + 1 < text.size(); ++i) {
+        if (text[i] == '!' && (i == 0 || text[i - 1] == ' ') && referenceFindBang(bangTokenAt(text, i))) {
+            return i;
+        }
+    }
+    return SIZE_MAX;
+}
+
+// The whole response for a request target, following the rules listed at renderSearchResponse
+std::string referenceSearchResponse(const std::string_view url) {
+    static const RedirectTemplate defaultRedirect = compileRedirectTemplate(DEFAULT_SEARCH_URL);
+    auto render = [](const RedirectTemplate &redirect, const std::string_view query) {
+        const std::string encoded = referenceEncode(query);
+        std::string response(maxRedirectResponseSize(redirect, encoded), '\0');
+        return std::string(createRedirectResponse(redirect, encoded, response.data()));
+    };
+
+    std::string_view queryString;
+    if (const size_t question = url.find('?'); question != std::string_view::npos) {
+        queryString = url.substr(question + 1);
+        queryString = queryString.substr(0, queryString.find(' '));
+    }
+    if (!queryString.starts_with(QUERY_PARAM.substr(1))) {
+        return render(defaultRedirect, {});
+    }
+
+    const std::string decoded = referenceDecode(queryString.substr(QUERY_PARAM.size() - 1));
+    if (decoded.starts_with('!')) {
+        const std::string_view token = bangTokenAt(decoded, 0);
+        if (const Bang *bang = referenceFindBang(token)) {
+            if (token.size() < decoded.size()) {
+                return render(bang->redirect, std::string_view(decoded).substr(token.size() + 1));
+            }
+            return render(bang->domainRedirect ? *bang->domainRedirect : bang->redirect, {});
+        }
+    }
+
+    // Past position 0, a bang at position 1 counts whatever precedes it
+    const size_t found = decoded.empty() ? SIZE_MAX : referenceBangPosition(std::string_view(decoded).substr(1));
+    if (found == SIZE_MAX) {
+        return render(defaultRedirect, decoded);
+    }
+
+    // The bang goes, the space after it too, and a space takes its place
+    const size_t position = found + 1;
+    const std::string_view token = bangTokenAt(decoded, position);
+    std::string query = decoded.substr(0, position);
+    if (position + token.size() < decoded.size()) {
+        query += ' ';
+        query += decoded.substr(position + token.size() + 1);
+    }
+    return render(referenceFindBang(token)->redirect, query);
+}
+
+// Bytes that end right before an inaccessible page, so a kernel that reads or writes past the span it was handed
+// faults instead of passing by accident
+class GuardedSpan {
+public:
+    explicit GuardedSpan(const size_t capacity) : m_pageSize(sysconf(_SC_PAGESIZE)) {
+        m_size = (capacity + m_pageSize - 1) / m_pageSize * m_pageSize;
+        void *base = mmap(nullptr, m_size + m_pageSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (base == MAP_FAILED) throw std::bad_alloc();
+        m_base = static_cast<char *>(base);
+        mprotect(m_base + m_size, m_pageSize, PROT_NONE);
+    }
+
+    ~GuardedSpan() {
+        munmap(m_base, m_size + m_pageSize);
+    }
+
+    GuardedSpan(const GuardedSpan &) = delete;
+
+    GuardedSpan &operator=(const GuardedSpan &) = delete;
+
+    [[nodiscard]] size_t capacity() const { return m_size; }
+
+    // The last size bytes before the guard page
+    [[nodiscard]] char *last(const size_t size) const { return m_base + m_size - size; }
+
+    std::string_view place(const std::string_view bytes) const {
+        char *start = last(bytes.size());
+        memcpy(start, bytes.data(), bytes.size());
+        return {start, bytes.size()};
+    }
+
+private:
+    size_t m_pageSize;
+    size_t m_size;
+    char *m_base;
+};
+
+// Query text built to hit the kernels' edges: lengths around every vector width, escapes straddling blocks,
+// truncated and bogus escapes, non-ASCII, and real bangs (plain, %-escaped, doubled) among spaces and '+'
+std::string randomFuzzInput(std::mt19937_64 &rng, const std::vector<std::string> &triggers) {
+    size_t length;
+    switch (rng() % 10) {
+        case 0: case 1: case 2:
+            length = 16 * (1 + rng() % 5) + rng() % 7 - 3; // 13 to 83, around the 16, 32 and 64 byte blocks
+            break;
+        case 3:
+            length = rng() % 1024;
+            break;
+        default:
+            length = rng() % 80;
+    }
+
+    static constexpr std::string_view pieces[] = {
+        "%", "%2", "%20", "%21", "%25", "%2%41", "%%", "%zz", "%4", "%c3%a9", "%E2%82%AC", "%00", "%7e", "%7E",
+        "+", "++", " ", "!", "!!", "+!", "a", "Z", "9", "-", ".", "_", "~", "[", "`", "\\", "\x7f", "\x80", "\xff",
+        "\xc3\xa9", "%P0", "%0p", "%`1"
+    };
+    std::string text;
+    switch (rng() % 4) {
+        case 0: // Any bytes at all
+            while (text.size() < length) text += static_cast<char>(rng());
+            break;
+        case 1: // Hex digits with a sprinkling of '%' and '+'
+            while (text.size() < length) text += "%%+0123456789abcdefABCDEFxyz"[rng() % 28];
+            break;
+        default: // Words, escapes and bangs
+            while (text.size() < length) {
+                const auto kind = rng() % 8;
+                if (kind < 2 && !triggers.empty()) {
+                    const std::string &trigger = triggers[rng() % triggers.size()];
+                    text += kind == 0 ? trigger : "%21" + trigger.substr(1);
+                } else if (kind < 4) {
+                    for (auto n = rng() % 20; n > 0; --n) text += "abcdefghijklmnop+"[rng() % 17];
+                } else {
+                    text += pieces[rng() % std::size(pieces)];
+                }
+            }
+            text.resize(length);
+    }
+    return text;
+}
+
+// The parsed fields of a request, or "npos" while its headers are incomplete, to compare parser tiers by
+std::string describeRequest(const std::string_view data) {
+    HttpRequest request;
+    const size_t length = parseHttpRequest(data, request);
+    if (length == std::string_view::npos) return "npos";
+    std::string description = std::to_string(length);
+    for (const std::string_view field: {request.method, request.target, request.path, request.query, request.version,
+                                        request.connection, request.host, request.acceptEncoding, request.ifNoneMatch}) {
+        description += '|';
+        description += field;
+    }
+    return description;
+}
+
+constexpr size_t FUZZ_ITERATIONS = 100000;
+
+// Runs urlDecode, urlEncode, findFirstValidBangPosition and both search paths (processQuery and the fused
+// renderQueryResponse) on random and adversarial inputs, at every SIMD tier this CPU has, against the reference
+// versions above. The request parser, which has no reference version, is checked against its scalar tier. Inputs and outputs sit right before a guard page and have only the documented room.
+int runDifferentialFuzz(const uint64_t seed, const size_t iterations) {
+    std::cout << "=============== DIFFERENTIAL FUZZ ===============" << std::endl;
+
+    const SimdTier initialTier = activeSimdTier();
+    std::vector<SimdTier> tiers;
+    for (int tier = 0; tier <= static_cast<int>(detectSimdTier()); ++tier) {
+        tiers.push_back(static_cast<SimdTier>(tier));
+    }
+
+    std::vector<std::string> triggers;
+    triggers.reserve(allBangs().size());
+    for (const auto &trigger: allBangs() | std::views::keys) {
+        triggers.push_back(trigger);
+    }
+
+    GuardedSpan input(1 << 12);
+    GuardedSpan output(1 << 16);
+    std::vector<char> decodeBuffer(1 << 12);
+    std::vector<char> encodeBuffer(1 << 14);
+    std::vector<char> responseBuffer(1 << 16);
+
+    size_t mismatches = 0;
+    auto check = [&](const std::string_view kernel, const SimdTier tier, const std::string_view in,
+                     const std::string_view expected, const std::string_view actual) {
+        if (expected == actual) return;
+        if (mismatches++ < 10) {
+            std::cerr << kernel << " (" << simdTierName(tier) << ") differs on \"" << printable(in) << "\"\n"
+                    << "  expected \"" << printable(expected) << "\"\n"
+                    << "  got      \"" << printable(actual) << "\"\n";
+        }
+    };
+
+    std::mt19937_64 rng(seed);
+    for (size_t i = 0; i < iterations; ++i) {
+        const std::string text = randomFuzzInput(rng, triggers);
+        const std::string url = (rng() % 16 ? "/search?q=" : "/search?") + text;
+
+        const std::string decoded = referenceDecode(text);
+        const std::string encoded = referenceEncode(text);
+        const size_t bangPosition = referenceBangPosition(decoded);
+        const std::string response = referenceSearchResponse(url);
+
+        // The query doubles as a header value; cut short now and then so the headers never end
+        std::string request = "GET " + url + " HTTP/1.1\r\nHost: x\r\nConnection: " + text + "\r\n\r\n";
+        if (rng() % 8 == 0) request.resize(rng() % request.size());
+        setSimdTier(SimdTier::Scalar);
+        const std::string parsed = describeRequest(input.place(request));
+        const std::string headersEnd = std::to_string(findHeadersEnd(request, 0));
+
+        for (const SimdTier tier: tiers) {
+            setSimdTier(tier);
+
+            // The kernels NUL-terminate their output
+            const std::string_view rawText = input.place(text);
+            char *out = output.last(text.size() + 1);
+            const size_t decodedLen = urlDecode(rawText, out);
+            check("urlDecode", tier, text, decoded + '\0', std::string_view(out, decodedLen + 1));
+
+            out = output.last(3 * text.size() + 1);
+            const size_t encodedLen = urlEncode(rawText, out);
+            check("urlEncode", tier, text, encoded + '\0', std::string_view(out, encodedLen + 1));
+
+            const std::string_view rawDecoded = input.place(decoded);
+            const size_t position = findFirstValidBangPosition(rawDecoded.data(), rawDecoded.size());
+            check("findFirstValidBangPosition", tier, decoded, std::to_string(bangPosition),
+                  std::to_string(position));
+
+            const auto [redirect, query] = processQuery(url, decodeBuffer.data(), encodeBuffer.data());
+            check("processQuery", tier, url, response,
+                  createRedirectResponse(*redirect, query, responseBuffer.data()));
+
+            const std::string_view rawUrl = input.place(url);
+            const size_t responseRoom = maxSearchResponseSize(rawUrl);
+            out = output.last(responseRoom);
+            check("renderQueryResponse", tier, url, response,
+                  std::string_view(out, renderQueryResponse(rawUrl, out)));
+
+            const std::string_view rawRequest = input.place(request);
+            check("parseHttpRequest", tier, request, parsed, describeRequest(rawRequest));
+            check("findHeadersEnd", tier, request, headersEnd, std::to_string(findHeadersEnd(rawRequest, 0)));
+        }
+    }
+    setSimdTier(initialTier);
+
+    std::cout << "Checked " << iterations << " inputs (seed " << seed << ") on tiers";
+    for (const SimdTier tier: tiers) {
+        std::cout << " " << simdTierName(tier);
+    }
+    std::cout << ": " << mismatches << " mismatches" << std::endl;
+    if (mismatches > 0) {
+        std::cout << "FAILED" << std::endl;
         return 1;
     }
-    std::cout << "Successfully loaded " << ALL_BANGS.size() << " bang URLs\n";
+    std::cout << "PASSED" << std::endl;
+    return 0;
+}
 
+int main(const int argc, char *argv[]) {
     // RNG
     std::random_device rd;
     std::mt19937 rng(rd());
@@ -426,6 +884,9 @@ int main(const int argc, char *argv[]) {
     std::string serverAddress = "127.0.0.1";
     int port = 3000;
     int threads = -1; // -1 means use 1 thread (default)
+    bool keepAlive = false;
+    uint64_t seed = rd();
+    std::string upstreamUrl; // Empty to benchmark the built-in bangs, the same on every run and without a network
 
     for (int i = 1; i < argc; ++i) {
         if (std::string arg = argv[i]; arg == "--network" || arg == "-n") {
@@ -436,6 +897,27 @@ int main(const int argc, char *argv[]) {
             port = std::stoi(argv[++i]);
         } else if ((arg == "--threads" || arg == "-t") && i + 1 < argc) {
             threads = std::stoi(argv[++i]);
+        } else if (arg == "--keep-alive" || arg == "-k") {
+            keepAlive = true;
+        } else if (arg == "--check-allocs") {
+            mode = "check-allocs";
+        } else if (arg == "--fuzz") {
+            mode = "fuzz";
+        } else if (arg == "--seed" && i + 1 < argc) {
+            seed = std::stoull(argv[++i]);
+        } else if (arg == "--upstream" && i + 1 < argc) {
+            upstreamUrl = argv[++i];
+        } else if (arg == "--simd" && i + 1 < argc) {
+            const auto tier = parseSimdTier(argv[++i]);
+            if (!tier) {
+                std::cerr << "Unknown SIMD tier " << argv[i] << " (expected scalar, sse4.2, avx2 or avx512)\n";
+                return 1;
+            }
+            if (!setSimdTier(*tier)) {
+                std::cerr << "This CPU does not support " << argv[i] << ", the widest it has is "
+                        << simdTierName(detectSimdTier()) << "\n";
+                return 1;
+            }
         } else if (arg == "--help" || arg == "-h") {
             std::cout << "Usage: benchmark [options]\n"
                     << "Options:\n"
@@ -443,13 +925,42 @@ int main(const int argc, char *argv[]) {
                     << "  --address, -a ADDR    Server address (default: 127.0.0.1)\n"
                     << "  --port, -p PORT       Server port (default: 3000)\n"
                     << "  --threads, -t THREADS Number of threads for benchmark (default: 1, 0 = all available)\n"
+                    << "  --keep-alive, -k      Reuse one connection per thread in the network benchmark\n"
+                    << "  --check-allocs        Fail if serving the query corpus allocates on the heap\n"
+                    << "  --fuzz                Check every SIMD tier against the reference implementations\n"
+                    << "  --seed SEED           Seed for --fuzz (default: random)\n"
+                    << "  --upstream URL        Load the bangs from URL, e.g. https://duckduckgo.com/bang.js\n"
+                    << "                        (default: the ones built in, or DuckDuckGo's without any)\n"
+                    << "  --simd TIER           Force the SIMD kernels to scalar, sse4.2, avx2 or avx512\n"
+                    << "                        (default: the widest this CPU supports)\n"
                     << "  --help, -h            Show this help message\n";
             return 0;
         }
     }
 
+    if (upstreamUrl.empty() && !loadEmbeddedBangData()) {
+        std::cout << "No bangs were built in (see Building in README.md), using the upstream ones\n";
+        upstreamUrl = "https://duckduckgo.com/bang.js";
+    }
+    if (!upstreamUrl.empty()) {
+        std::cout << "Loading bang data from " << upstreamUrl << "..." << std::endl;
+        if (!loadBangDataFromUrl(upstreamUrl)) {
+            std::cerr << "Failed to load bang data from API\n";
+            return 1;
+        }
+        std::cout << "Successfully loaded " << allBangs().size() << " bang URLs\n";
+    }
+
+    if (mode != "network") {
+        std::cout << "SIMD kernels: " << simdTierName(activeSimdTier()) << "\n";
+    }
+
     if (mode == "network") {
-        runNetworkBenchmark(testUrls, serverAddress, port, threads);
+        runNetworkBenchmark(testUrls, serverAddress, port, threads, keepAlive);
+    } else if (mode == "check-allocs") {
+        return runAllocationCheck(testUrls);
+    } else if (mode == "fuzz") {
+        return runDifferentialFuzz(seed, FUZZ_ITERATIONS);
     } else {
         runInProcessBenchmark(testUrls, threads);
     }
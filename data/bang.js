@@ -0,0 +1 @@
+[{"c":"Online Services","d":"www.google.com","s":"Google","sc":"Search","t":"g","u":"https://www.google.com/search?q={{{s}}}"},{"c":"Online Services","d":"duckduckgo.com","s":"DuckDuckGo","sc":"Search","t":"ddg","u":"https://duckduckgo.com/?q={{{s}}}"},{"c":"Online Services","d":"www.bing.com","s":"Bing","sc":"Search","t":"b","u":"https://www.bing.com/search?q={{{s}}}"},{"c":"Online Services","d":"www.bing.com","s":"Bing","sc":"Search","t":"bing","u":"https://www.bing.com/search?q={{{s}}}"},{"c":"Online Services","d":"search.yahoo.com","s":"Yahoo","sc":"Search","t":"y","u":"https://search.yahoo.com/search?p={{{s}}}"},{"c":"Online Services","d":"yandex.com","s":"Yandex","sc":"Search","t":"yandex","u":"https://yandex.com/search/?text={{{s}}}"},{"c":"Online Services","d":"search.brave.com","s":"Brave Search","sc":"Search","t":"brave","u":"https://search.brave.com/search?q={{{s}}}"},{"c":"Online Services","d":"www.startpage.com","s":"Startpage","sc":"Search","t":"sp","u":"https://www.startpage.com/do/search?query={{{s}}}"},{"c":"Online Services","d":"www.ecosia.org","s":"Ecosia","sc":"Search","t":"ecosia","u":"https://www.ecosia.org/search?q={{{s}}}"},{"c":"Online Services","d":"kagi.com","s":"Kagi","sc":"Search","t":"kagi","u":"https://kagi.com/search?q={{{s}}}"},{"c":"Online Services","d":"www.google.com","s":"Google Images","sc":"Google","t":"gi","u":"https://www.google.com/search?tbm=isch&q={{{s}}}"},{"c":"Online Services","d":"www.google.com","s":"Google Images","sc":"Google","t":"img","u":"https://www.google.com/search?tbm=isch&q={{{s}}}"},{"c":"Online Services","d":"news.google.com","s":"Google News","sc":"Google","t":"gn","u":"https://news.google.com/search?q={{{s}}}"},{"c":"Online Services","d":"www.google.com","s":"Google Maps","sc":"Google","t":"gm","u":"https://www.google.com/maps/search/{{{s}}}"},{"c":"Online Services","d":"www.google.com","s":"Google Maps","sc":"Google","t":"maps","u":"https://www.google.com/maps/search/{{{s}}}"},{"c":"Online Services","d":"translate.google.com","s":"Google Translate","sc":"Google","t":"gt","u":"https://translate.google.com/?text={{{s}}}"},{"c":"Online Services","d":"translate.google.com","s":"Google Translate","sc":"Google","t":"translate","u":"https://translate.google.com/?text={{{s}}}"},{"c":"Online Services","d":"scholar.google.com","s":"Google Scholar","sc":"Google","t":"scholar","u":"https://scholar.google.com/scholar?q={{{s}}}"},{"c":"Online Services","d":"scholar.google.com","s":"Google Scholar","sc":"Google","t":"gs","u":"https://scholar.google.com/scholar?q={{{s}}}"},{"c":"Online Services","d":"drive.google.com","s":"Google Drive","sc":"Google","t":"drive","u":"https://drive.google.com/drive/search?q={{{s}}}"},{"c":"Online Services","d":"mail.google.com","s":"Gmail","sc":"Google","t":"gmail","u":"https://mail.google.com/mail/u/0/#search/{{{s}}}"},{"c":"Online Services","d":"www.google.com","s":"Google Videos","sc":"Google","t":"gv","u":"https://www.google.com/search?tbm=vid&q={{{s}}}"},{"c":"Online Services","d":"www.google.com","s":"Google Shopping","sc":"Google","t":"gshop","u":"https://www.google.com/search?tbm=shop&q={{{s}}}"},{"c":"Online Services","d":"books.google.com","s":"Google Books","sc":"Google","t":"gb","u":"https://www.google.com/search?tbm=bks&q={{{s}}}"},{"c":"Online Services","d":"patents.google.com","s":"Google Patents","sc":"Google","t":"patents","u":"https://patents.google.com/?q={{{s}}}"},{"c":"Research","d":"en.wikipedia.org","s":"Wikipedia","sc":"Reference","t":"w","u":"https://en.wikipedia.org/wiki/Special:Search?search={{{s}}}"},{"c":"Research","d":"en.wikipedia.org","s":"Wikipedia","sc":"Reference","t":"wiki","u":"https://en.wikipedia.org/wiki/Special:Search?search={{{s}}}"},{"c":"Research","d":"en.wikipedia.org","s":"Wikipedia","sc":"Reference","t":"wikipedia","u":"https://en.wikipedia.org/wiki/Special:Search?search={{{s}}}"},{"c":"Research","d":"de.wikipedia.org","s":"Wikipedia (German)","sc":"Reference","t":"wde","u":"https://de.wikipedia.org/wiki/Special:Search?search={{{s}}}"},{"c":"Research","d":"fr.wikipedia.org","s":"Wikipedia (French)","sc":"Reference","t":"wfr","u":"https://fr.wikipedia.org/wiki/Special:Search?search={{{s}}}"},{"c":"Research","d":"es.wikipedia.org","s":"Wikipedia (Spanish)","sc":"Reference","t":"wes","u":"https://es.wikipedia.org/wiki/Special:Search?search={{{s}}}"},{"c":"Research","d":"ja.wikipedia.org","s":"Wikipedia (Japanese)","sc":"Reference","t":"wja","u":"https://ja.wikipedia.org/wiki/Special:Search?search={{{s}}}"},{"c":"Research","d":"en.wiktionary.org","s":"Wiktionary","sc":"Reference","t":"wt","u":"https://en.wiktionary.org/wiki/Special:Search?search={{{s}}}"},{"c":"Research","d":"en.wiktionary.org","s":"Wiktionary","sc":"Reference","t":"wiktionary","u":"https://en.wiktionary.org/wiki/Special:Search?search={{{s}}}"},{"c":"Research","d":"www.wikidata.org","s":"Wikidata","sc":"Reference","t":"wd","u":"https://www.wikidata.org/w/index.php?search={{{s}}}"},{"c":"Research","d":"commons.wikimedia.org","s":"Wikimedia Commons","sc":"Reference","t":"commons","u":"https://commons.wikimedia.org/w/index.php?search={{{s}}}"},{"c":"Research","d":"en.wikiquote.org","s":"Wikiquote","sc":"Reference","t":"wq","u":"https://en.wikiquote.org/wiki/Special:Search?search={{{s}}}"},{"c":"Research","d":"www.britannica.com","s":"Encyclopaedia Britannica","sc":"Reference","t":"britannica","u":"https://www.britannica.com/search?query={{{s}}}"},{"c":"Research","d":"www.merriam-webster.com","s":"Merriam-Webster","sc":"Dictionary","t":"mw","u":"https://www.merriam-webster.com/dictionary/{{{s}}}"},{"c":"Research","d":"www.dictionary.com","s":"Dictionary.com","sc":"Dictionary","t":"dict","u":"https://www.dictionary.com/browse/{{{s}}}"},{"c":"Research","d":"www.thesaurus.com","s":"Thesaurus.com","sc":"Dictionary","t":"thesaurus","u":"https://www.thesaurus.com/browse/{{{s}}}"},{"c":"Research","d":"www.urbandictionary.com","s":"Urban Dictionary","sc":"Dictionary","t":"ud","u":"https://www.urbandictionary.com/define.php?term={{{s}}}"},{"c":"Research","d":"www.etymonline.com","s":"Online Etymology Dictionary","sc":"Dictionary","t":"etym","u":"https://www.etymonline.com/search?q={{{s}}}"},{"c":"Research","d":"dictionary.cambridge.org","s":"Cambridge Dictionary","sc":"Dictionary","t":"cambridge","u":"https://dictionary.cambridge.org/dictionary/english/{{{s}}}"},{"c":"Research","d":"www.deepl.com","s":"DeepL","sc":"Dictionary","t":"deepl","u":"https://www.deepl.com/translator#auto/en/{{{s}}}"},{"c":"Research","d":"dict.leo.org","s":"LEO","sc":"Dictionary","t":"leo","u":"https://dict.leo.org/german-english/{{{s}}}"},{"c":"Research","d":"www.linguee.com","s":"Linguee","sc":"Dictionary","t":"linguee","u":"https://www.linguee.com/english-german/search?query={{{s}}}"},{"c":"Research","d":"arxiv.org","s":"arXiv","sc":"Academic","t":"arxiv","u":"https://arxiv.org/search/?query={{{s}}}&searchtype=all"},{"c":"Research","d":"pubmed.ncbi.nlm.nih.gov","s":"PubMed","sc":"Academic","t":"pubmed","u":"https://pubmed.ncbi.nlm.nih.gov/?term={{{s}}}"},{"c":"Research","d":"www.semanticscholar.org","s":"Semantic Scholar","sc":"Academic","t":"ss","u":"https://www.semanticscholar.org/search?q={{{s}}}"},{"c":"Research","d":"dblp.org","s":"dblp","sc":"Academic","t":"dblp","u":"https://dblp.org/search?q={{{s}}}"},{"c":"Research","d":"www.jstor.org","s":"JSTOR","sc":"Academic","t":"jstor","u":"https://www.jstor.org/action/doBasicSearch?Query={{{s}}}"},{"c":"Research","d":"www.wolframalpha.com","s":"Wolfram Alpha","sc":"Academic","t":"wa","u":"https://www.wolframalpha.com/input/?i={{{s}}}"},{"c":"Research","d":"oeis.org","s":"OEIS","sc":"Academic","t":"oeis","u":"https://oeis.org/search?q={{{s}}}"},{"c":"Research","d":"archive.org","s":"Internet Archive","sc":"Academic","t":"archive","u":"https://archive.org/search?query={{{s}}}"},{"c":"Research","d":"web.archive.org","s":"Wayback Machine","sc":"Academic","t":"wayback","u":"https://web.archive.org/web/*/{{{s}}}"},{"c":"Research","d":"www.khanacademy.org","s":"Khan Academy","sc":"Learning","t":"khan","u":"https://www.khanacademy.org/search?page_search_query={{{s}}}"},{"c":"Research","d":"www.goodreads.com","s":"Goodreads","sc":"Learning","t":"gr","u":"https://www.goodreads.com/search?q={{{s}}}"},{"c":"Research","d":"www.gutenberg.org","s":"Project Gutenberg","sc":"Learning","t":"gutenberg","u":"https://www.gutenberg.org/ebooks/search/?query={{{s}}}"},{"c":"Research","d":"openlibrary.org","s":"Open Library","sc":"Learning","t":"ol","u":"https://openlibrary.org/search?q={{{s}}}"},{"c":"Tech","d":"github.com","s":"GitHub","sc":"Programming","t":"gh","u":"https://github.com/search?q={{{s}}}"},{"c":"Tech","d":"github.com","s":"GitHub","sc":"Programming","t":"github","u":"https://github.com/search?q={{{s}}}"},{"c":"Tech","d":"gitlab.com","s":"GitLab","sc":"Programming","t":"gitlab","u":"https://gitlab.com/search?search={{{s}}}"},{"c":"Tech","d":"codeberg.org","s":"Codeberg","sc":"Programming","t":"codeberg","u":"https://codeberg.org/explore/repos?q={{{s}}}"},{"c":"Tech","d":"stackoverflow.com","s":"Stack Overflow","sc":"Programming","t":"so","u":"https://stackoverflow.com/search?q={{{s}}}"},{"c":"Tech","d":"stackoverflow.com","s":"Stack Overflow","sc":"Programming","t":"stackoverflow","u":"https://stackoverflow.com/search?q={{{s}}}"},{"c":"Tech","d":"superuser.com","s":"Super User","sc":"Programming","t":"su","u":"https://superuser.com/search?q={{{s}}}"},{"c":"Tech","d":"serverfault.com","s":"Server Fault","sc":"Programming","t":"sf","u":"https://serverfault.com/search?q={{{s}}}"},{"c":"Tech","d":"askubuntu.com","s":"Ask Ubuntu","sc":"Programming","t":"au","u":"https://askubuntu.com/search?q={{{s}}}"},{"c":"Tech","d":"unix.stackexchange.com","s":"Unix & Linux Stack Exchange","sc":"Programming","t":"ul","u":"https://unix.stackexchange.com/search?q={{{s}}}"},{"c":"Tech","d":"en.cppreference.com","s":"cppreference","sc":"Programming","t":"cpp","u":"https://duckduckgo.com/?q=site%3Aen.cppreference.com+{{{s}}}"},{"c":"Tech","d":"en.cppreference.com","s":"cppreference","sc":"Programming","t":"cppref","u":"https://duckduckgo.com/?q=site%3Aen.cppreference.com+{{{s}}}"},{"c":"Tech","d":"developer.mozilla.org","s":"MDN Web Docs","sc":"Programming","t":"mdn","u":"https://developer.mozilla.org/en-US/search?q={{{s}}}"},{"c":"Tech","d":"docs.python.org","s":"Python Documentation","sc":"Programming","t":"python","u":"https://docs.python.org/3/search.html?q={{{s}}}"},{"c":"Tech","d":"docs.python.org","s":"Python Documentation","sc":"Programming","t":"py","u":"https://docs.python.org/3/search.html?q={{{s}}}"},{"c":"Tech","d":"pypi.org","s":"PyPI","sc":"Programming","t":"pypi","u":"https://pypi.org/search/?q={{{s}}}"},{"c":"Tech","d":"www.npmjs.com","s":"npm","sc":"Programming","t":"npm","u":"https://www.npmjs.com/search?q={{{s}}}"},{"c":"Tech","d":"crates.io","s":"crates.io","sc":"Programming","t":"crates","u":"https://crates.io/search?q={{{s}}}"},{"c":"Tech","d":"docs.rs","s":"Docs.rs","sc":"Programming","t":"docs.rs","u":"https://docs.rs/releases/search?query={{{s}}}"},{"c":"Tech","d":"doc.rust-lang.org","s":"Rust Standard Library","sc":"Programming","t":"rust","u":"https://doc.rust-lang.org/std/?search={{{s}}}"},{"c":"Tech","d":"pkg.go.dev","s":"Go Packages","sc":"Programming","t":"go","u":"https://pkg.go.dev/search?q={{{s}}}"},{"c":"Tech","d":"pkg.go.dev","s":"Go Packages","sc":"Programming","t":"godoc","u":"https://pkg.go.dev/search?q={{{s}}}"},{"c":"Tech","d":"hackage.haskell.org","s":"Hackage","sc":"Programming","t":"hackage","u":"https://hackage.haskell.org/packages/search?terms={{{s}}}"},{"c":"Tech","d":"hoogle.haskell.org","s":"Hoogle","sc":"Programming","t":"hoogle","u":"https://hoogle.haskell.org/?hoogle={{{s}}}"},{"c":"Tech","d":"rubygems.org","s":"RubyGems","sc":"Programming","t":"gem","u":"https://rubygems.org/search?query={{{s}}}"},{"c":"Tech","d":"packagist.org","s":"Packagist","sc":"Programming","t":"packagist","u":"https://packagist.org/?query={{{s}}}"},{"c":"Tech","d":"www.php.net","s":"PHP Manual","sc":"Programming","t":"php","u":"https://www.php.net/manual-lookup.php?pattern={{{s}}}"},{"c":"Tech","d":"search.maven.org","s":"Maven Central","sc":"Programming","t":"maven","u":"https://search.maven.org/search?q={{{s}}}"},{"c":"Tech","d":"www.nuget.org","s":"NuGet","sc":"Programming","t":"nuget","u":"https://www.nuget.org/packages?q={{{s}}}"},{"c":"Tech","d":"learn.microsoft.com","s":"Microsoft Learn","sc":"Programming","t":"msdn","u":"https://learn.microsoft.com/en-us/search/?terms={{{s}}}"},{"c":"Tech","d":"hub.docker.com","s":"Docker Hub","sc":"Programming","t":"docker","u":"https://hub.docker.com/search?q={{{s}}}"},{"c":"Tech","d":"caniuse.com","s":"Can I use","sc":"Programming","t":"caniuse","u":"https://caniuse.com/?search={{{s}}}"},{"c":"Tech","d":"regex101.com","s":"regex101","sc":"Programming","t":"regex","u":"https://regex101.com/?regex={{{s}}}"},{"c":"Tech","d":"godbolt.org","s":"Compiler Explorer","sc":"Programming","t":"godbolt","u":"https://godbolt.org/#{{{s}}}"},{"c":"Tech","d":"news.ycombinator.com","s":"Hacker News","sc":"Programming","t":"hn","u":"https://hn.algolia.com/?q={{{s}}}"},{"c":"Tech","d":"lobste.rs","s":"Lobsters","sc":"Programming","t":"lobsters","u":"https://lobste.rs/search?q={{{s}}}"},{"c":"Tech","d":"www.man7.org","s":"Linux man pages","sc":"Programming","t":"man","u":"https://man7.org/linux/man-pages/dir_all_alphabetic.html#{{{s}}}"},{"c":"Tech","d":"wiki.archlinux.org","s":"ArchWiki","sc":"Sysadmin","t":"aw","u":"https://wiki.archlinux.org/index.php?search={{{s}}}"},{"c":"Tech","d":"wiki.archlinux.org","s":"ArchWiki","sc":"Sysadmin","t":"archwiki","u":"https://wiki.archlinux.org/index.php?search={{{s}}}"},{"c":"Tech","d":"aur.archlinux.org","s":"Arch User Repository","sc":"Sysadmin","t":"aur","u":"https://aur.archlinux.org/packages?K={{{s}}}"},{"c":"Tech","d":"archlinux.org","s":"Arch Linux Packages","sc":"Sysadmin","t":"archpkg","u":"https://archlinux.org/packages/?q={{{s}}}"},{"c":"Tech","d":"packages.debian.org","s":"Debian Packages","sc":"Sysadmin","t":"debian","u":"https://packages.debian.org/search?keywords={{{s}}}"},{"c":"Tech","d":"packages.ubuntu.com","s":"Ubuntu Packages","sc":"Sysadmin","t":"ubuntu","u":"https://packages.ubuntu.com/search?keywords={{{s}}}"},{"c":"Tech","d":"search.nixos.org","s":"NixOS Packages","sc":"Sysadmin","t":"nixpkgs","u":"https://search.nixos.org/packages?query={{{s}}}"},{"c":"Tech","d":"formulae.brew.sh","s":"Homebrew Formulae","sc":"Sysadmin","t":"brew","u":"https://formulae.brew.sh/formula/{{{s}}}"},{"c":"Tech","d":"www.shodan.io","s":"Shodan","sc":"Sysadmin","t":"shodan","u":"https://www.shodan.io/search?query={{{s}}}"},{"c":"Tech","d":"who.is","s":"who.is","sc":"Sysadmin","t":"whois","u":"https://who.is/whois/{{{s}}}"},{"c":"Tech","d":"downforeveryoneorjustme.com","s":"Down for Everyone or Just Me","sc":"Sysadmin","t":"down","u":"https://downforeveryoneorjustme.com/{{{s}}}"},{"c":"Tech","d":"nvd.nist.gov","s":"National Vulnerability Database","sc":"Security","t":"cve","u":"https://nvd.nist.gov/vuln/search/results?query={{{s}}}"},{"c":"Tech","d":"www.exploit-db.com","s":"Exploit Database","sc":"Security","t":"exploitdb","u":"https://www.exploit-db.com/search?q={{{s}}}"},{"c":"Multimedia","d":"www.youtube.com","s":"YouTube","sc":"Video","t":"yt","u":"https://www.youtube.com/results?search_query={{{s}}}"},{"c":"Multimedia","d":"www.youtube.com","s":"YouTube","sc":"Video","t":"youtube","u":"https://www.youtube.com/results?search_query={{{s}}}"},{"c":"Multimedia","d":"vimeo.com","s":"Vimeo","sc":"Video","t":"vimeo","u":"https://vimeo.com/search?q={{{s}}}"},{"c":"Multimedia","d":"www.twitch.tv","s":"Twitch","sc":"Video","t":"twitch","u":"https://www.twitch.tv/search?term={{{s}}}"},{"c":"Multimedia","d":"www.dailymotion.com","s":"Dailymotion","sc":"Video","t":"dm","u":"https://www.dailymotion.com/search/{{{s}}}"},{"c":"Multimedia","d":"www.netflix.com","s":"Netflix","sc":"Video","t":"netflix","u":"https://www.netflix.com/search?q={{{s}}}"},{"c":"Multimedia","d":"www.imdb.com","s":"IMDb","sc":"Video","t":"imdb","u":"https://www.imdb.com/find?q={{{s}}}"},{"c":"Multimedia","d":"www.themoviedb.org","s":"TMDB","sc":"Video","t":"tmdb","u":"https://www.themoviedb.org/search?query={{{s}}}"},{"c":"Multimedia","d":"letterboxd.com","s":"Letterboxd","sc":"Video","t":"lb","u":"https://letterboxd.com/search/{{{s}}}/"},{"c":"Multimedia","d":"www.rottentomatoes.com","s":"Rotten Tomatoes","sc":"Video","t":"rt","u":"https://www.rottentomatoes.com/search?search={{{s}}}"},{"c":"Multimedia","d":"open.spotify.com","s":"Spotify","sc":"Music","t":"spotify","u":"https://open.spotify.com/search/{{{s}}}"},{"c":"Multimedia","d":"soundcloud.com","s":"SoundCloud","sc":"Music","t":"sc","u":"https://soundcloud.com/search?q={{{s}}}"},{"c":"Multimedia","d":"bandcamp.com","s":"Bandcamp","sc":"Music","t":"bandcamp","u":"https://bandcamp.com/search?q={{{s}}}"},{"c":"Multimedia","d":"www.last.fm","s":"Last.fm","sc":"Music","t":"lastfm","u":"https://www.last.fm/search?q={{{s}}}"},{"c":"Multimedia","d":"genius.com","s":"Genius","sc":"Music","t":"genius","u":"https://genius.com/search?q={{{s}}}"},{"c":"Multimedia","d":"www.discogs.com","s":"Discogs","sc":"Music","t":"discogs","u":"https://www.discogs.com/search/?q={{{s}}}"},{"c":"Multimedia","d":"musicbrainz.org","s":"MusicBrainz","sc":"Music","t":"mb","u":"https://musicbrainz.org/search?query={{{s}}}&type=artist"},{"c":"Multimedia","d":"www.flickr.com","s":"Flickr","sc":"Images","t":"flickr","u":"https://www.flickr.com/search/?text={{{s}}}"},{"c":"Multimedia","d":"unsplash.com","s":"Unsplash","sc":"Images","t":"unsplash","u":"https://unsplash.com/s/photos/{{{s}}}"},{"c":"Multimedia","d":"giphy.com","s":"GIPHY","sc":"Images","t":"giphy","u":"https://giphy.com/search/{{{s}}}"},{"c":"Multimedia","d":"www.pinterest.com","s":"Pinterest","sc":"Images","t":"pin","u":"https://www.pinterest.com/search/pins/?q={{{s}}}"},{"c":"Multimedia","d":"www.deviantart.com","s":"DeviantArt","sc":"Images","t":"da","u":"https://www.deviantart.com/search?q={{{s}}}"},{"c":"Online Services","d":"www.reddit.com","s":"Reddit","sc":"Social","t":"r","u":"https://www.reddit.com/search?q={{{s}}}"},{"c":"Online Services","d":"www.reddit.com","s":"Reddit","sc":"Social","t":"reddit","u":"https://www.reddit.com/search?q={{{s}}}"},{"c":"Online Services","d":"x.com","s":"X","sc":"Social","t":"x","u":"https://x.com/search?q={{{s}}}"},{"c":"Online Services","d":"x.com","s":"X","sc":"Social","t":"twitter","u":"https://x.com/search?q={{{s}}}"},{"c":"Online Services","d":"www.facebook.com","s":"Facebook","sc":"Social","t":"fb","u":"https://www.facebook.com/search/top/?q={{{s}}}"},{"c":"Online Services","d":"www.instagram.com","s":"Instagram","sc":"Social","t":"ig","u":"https://www.instagram.com/explore/tags/{{{s}}}/"},{"c":"Online Services","d":"www.linkedin.com","s":"LinkedIn","sc":"Social","t":"li","u":"https://www.linkedin.com/search/results/all/?keywords={{{s}}}"},{"c":"Online Services","d":"www.tiktok.com","s":"TikTok","sc":"Social","t":"tiktok","u":"https://www.tiktok.com/search?q={{{s}}}"},{"c":"Online Services","d":"mastodon.social","s":"Mastodon","sc":"Social","t":"mastodon","u":"https://mastodon.social/search?q={{{s}}}"},{"c":"Online Services","d":"bsky.app","s":"Bluesky","sc":"Social","t":"bsky","u":"https://bsky.app/search?q={{{s}}}"},{"c":"Online Services","d":"www.quora.com","s":"Quora","sc":"Social","t":"quora","u":"https://www.quora.com/search?q={{{s}}}"},{"c":"Online Services","d":"medium.com","s":"Medium","sc":"Social","t":"medium","u":"https://medium.com/search?q={{{s}}}"},{"c":"Shopping","d":"www.amazon.com","s":"Amazon","sc":"Online","t":"a","u":"https://www.amazon.com/s?k={{{s}}}"},{"c":"Shopping","d":"www.amazon.com","s":"Amazon","sc":"Online","t":"amazon","u":"https://www.amazon.com/s?k={{{s}}}"},{"c":"Shopping","d":"www.amazon.co.uk","s":"Amazon UK","sc":"Online","t":"auk","u":"https://www.amazon.co.uk/s?k={{{s}}}"},{"c":"Shopping","d":"www.amazon.de","s":"Amazon Germany","sc":"Online","t":"ade","u":"https://www.amazon.de/s?k={{{s}}}"},{"c":"Shopping","d":"www.ebay.com","s":"eBay","sc":"Online","t":"ebay","u":"https://www.ebay.com/sch/i.html?_nkw={{{s}}}"},{"c":"Shopping","d":"www.etsy.com","s":"Etsy","sc":"Online","t":"etsy","u":"https://www.etsy.com/search?q={{{s}}}"},{"c":"Shopping","d":"www.aliexpress.com","s":"AliExpress","sc":"Online","t":"ali","u":"https://www.aliexpress.com/wholesale?SearchText={{{s}}}"},{"c":"Shopping","d":"www.walmart.com","s":"Walmart","sc":"Online","t":"walmart","u":"https://www.walmart.com/search?q={{{s}}}"},{"c":"Shopping","d":"www.bestbuy.com","s":"Best Buy","sc":"Online","t":"bestbuy","u":"https://www.bestbuy.com/site/searchpage.jsp?st={{{s}}}"},{"c":"Shopping","d":"www.newegg.com","s":"Newegg","sc":"Online","t":"newegg","u":"https://www.newegg.com/p/pl?d={{{s}}}"},{"c":"Shopping","d":"camelcamelcamel.com","s":"camelcamelcamel","sc":"Online","t":"ccc","u":"https://camelcamelcamel.com/search?sq={{{s}}}"},{"c":"Entertainment","d":"store.steampowered.com","s":"Steam","sc":"Games","t":"steam","u":"https://store.steampowered.com/search/?term={{{s}}}"},{"c":"Entertainment","d":"www.gog.com","s":"GOG","sc":"Games","t":"gog","u":"https://www.gog.com/en/games?query={{{s}}}"},{"c":"Entertainment","d":"www.protondb.com","s":"ProtonDB","sc":"Games","t":"protondb","u":"https://www.protondb.com/search?q={{{s}}}"},{"c":"Entertainment","d":"www.metacritic.com","s":"Metacritic","sc":"Games","t":"mc","u":"https://www.metacritic.com/search/{{{s}}}/"},{"c":"Entertainment","d":"minecraft.wiki","s":"Minecraft Wiki","sc":"Games","t":"mcw","u":"https://minecraft.wiki/?search={{{s}}}"},{"c":"Entertainment","d":"myanimelist.net","s":"MyAnimeList","sc":"Anime","t":"mal","u":"https://myanimelist.net/search/all?q={{{s}}}"},{"c":"Entertainment","d":"anilist.co","s":"AniList","sc":"Anime","t":"anilist","u":"https://anilist.co/search/anime?search={{{s}}}"},{"c":"News","d":"www.bbc.co.uk","s":"BBC","sc":"General","t":"bbc","u":"https://www.bbc.co.uk/search?q={{{s}}}"},{"c":"News","d":"www.reuters.com","s":"Reuters","sc":"General","t":"reuters","u":"https://www.reuters.com/site-search/?query={{{s}}}"},{"c":"News","d":"www.theguardian.com","s":"The Guardian","sc":"General","t":"guardian","u":"https://www.theguardian.com/search?q={{{s}}}"},{"c":"News","d":"www.nytimes.com","s":"The New York Times","sc":"General","t":"nyt","u":"https://www.nytimes.com/search?query={{{s}}}"},{"c":"News","d":"apnews.com","s":"AP News","sc":"General","t":"ap","u":"https://apnews.com/search?q={{{s}}}"},{"c":"News","d":"www.cnn.com","s":"CNN","sc":"General","t":"cnn","u":"https://www.cnn.com/search?q={{{s}}}"},{"c":"News","d":"www.aljazeera.com","s":"Al Jazeera","sc":"General","t":"aj","u":"https://www.aljazeera.com/search/{{{s}}}"},{"c":"News","d":"finance.yahoo.com","s":"Yahoo Finance","sc":"Business","t":"yf","u":"https://finance.yahoo.com/quote/{{{s}}}"},{"c":"News","d":"www.bloomberg.com","s":"Bloomberg","sc":"Business","t":"bloomberg","u":"https://www.bloomberg.com/search?query={{{s}}}"},{"c":"Online Services","d":"www.openstreetmap.org","s":"OpenStreetMap","sc":"Maps","t":"osm","u":"https://www.openstreetmap.org/search?query={{{s}}}"},{"c":"Online Services","d":"www.bing.com","s":"Bing Maps","sc":"Maps","t":"bm","u":"https://www.bing.com/maps?q={{{s}}}"},{"c":"Online Services","d":"maps.apple.com","s":"Apple Maps","sc":"Maps","t":"am","u":"https://maps.apple.com/?q={{{s}}}"},{"c":"Online Services","d":"www.tripadvisor.com","s":"Tripadvisor","sc":"Travel","t":"ta","u":"https://www.tripadvisor.com/Search?q={{{s}}}"},{"c":"Online Services","d":"www.booking.com","s":"Booking.com","sc":"Travel","t":"booking","u":"https://www.booking.com/searchresults.html?ss={{{s}}}"},{"c":"Online Services","d":"www.airbnb.com","s":"Airbnb","sc":"Travel","t":"airbnb","u":"https://www.airbnb.com/s/{{{s}}}/homes"},{"c":"Online Services","d":"www.yelp.com","s":"Yelp","sc":"Travel","t":"yelp","u":"https://www.yelp.com/search?find_desc={{{s}}}"},{"c":"Online Services","d":"en.wikivoyage.org","s":"Wikivoyage","sc":"Travel","t":"wv","u":"https://en.wikivoyage.org/wiki/Special:Search?search={{{s}}}"},{"c":"Online Services","d":"chatgpt.com","s":"ChatGPT","sc":"Tools","t":"chatgpt","u":"https://chatgpt.com/?q={{{s}}}"},{"c":"Online Services","d":"www.perplexity.ai","s":"Perplexity","sc":"Tools","t":"perplexity","u":"https://www.perplexity.ai/search?q={{{s}}}"},{"c":"Online Services","d":"claude.ai","s":"Claude","sc":"Tools","t":"claude","u":"https://claude.ai/new?q={{{s}}}"},{"c":"Online Services","d":"huggingface.co","s":"Hugging Face","sc":"Tools","t":"hf","u":"https://huggingface.co/search/full-text?q={{{s}}}"},{"c":"Online Services","d":"www.virustotal.com","s":"VirusTotal","sc":"Tools","t":"vt","u":"https://www.virustotal.com/gui/search/{{{s}}}"},{"c":"Online Services","d":"ipinfo.io","s":"IPinfo","sc":"Tools","t":"ip","u":"https://ipinfo.io/{{{s}}}"},{"c":"Online Services","d":"www.timeanddate.com","s":"timeanddate.com","sc":"Tools","t":"time","u":"https://www.timeanddate.com/worldclock/results.html?query={{{s}}}"},{"c":"Online Services","d":"www.xe.com","s":"XE Currency Converter","sc":"Tools","t":"xe","u":"https://www.xe.com/currencyconverter/convert/?Amount={{{s}}}"},{"c":"Online Services","d":"www.zillow.com","s":"Zillow","sc":"Tools","t":"zillow","u":"https://www.zillow.com/homes/{{{s}}}_rb/"},{"c":"Online Services","d":"www.indeed.com","s":"Indeed","sc":"Tools","t":"indeed","u":"https://www.indeed.com/jobs?q={{{s}}}"}]
\ No newline at end of file
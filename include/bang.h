@@ -1,5 +1,6 @@
 #pragma once
 
+#include <memory>
 #include <string>
 #include <string_view>
 #include <optional>
@@ -8,6 +9,7 @@
 #include <absl/container/flat_hash_map.h>
 
 #include "simdjson.h"
+#include "http_handler.h"
 
 enum class Category {
     Entertainment,
@@ -29,6 +31,10 @@ struct Bang {
     std::string trigger;
     std::string url_template;
 
+    // Compiled by the loader from url_template and domain
+    RedirectTemplate redirect;
+    std::optional<RedirectTemplate> domainRedirect;
+
     Bang() = default;
 
     Bang(std::string t, std::string u)
@@ -48,9 +54,40 @@ struct Bang {
     }
 };
 
-extern absl::flat_hash_map<std::string, Bang> ALL_BANGS;
+class BangTable;
+struct HttpValidators;
+
+// Every bang loaded so far, keyed by trigger. Only the thread that loads bangs may call it; lookups go through
+// bangTable(), which every load rebuilds and publishes. Bangs restored from a snapshot or the binary are only copied
+// in here on the first call, or once a load layers other bangs over them.
+const absl::flat_hash_map<std::string, Bang> &allBangs();
 extern const std::unordered_map<std::string_view, Category> CATEGORY_MAP;
 
 bool loadBangDataFromUrl(const std::string &url);
 bool loadBangDataFromFile(const std::string &filePath);
+
+// Adds the bangs in json, an array in the upstream format (which custom files share), to bangs. Returns how many were
+// added, -1 if json is malformed.
+int parseBangData(simdjson::padded_string_view json, absl::flat_hash_map<std::string, Bang> &bangs);
+
+// Replaces the custom bangs with what filePath holds now (none if it is gone) and publishes the result. A file that
+// cannot be read or parsed leaves the current bangs in place and returns false.
+bool reloadBangDataFromFile(const std::string &filePath);
+
+// Fetches url again, as a conditional request against the copy loaded last, and when it has changed republishes it
+// with the custom bangs from customBangsPath layered over it (left out if they cannot be read or parsed). Returns
+// whether new bangs were published; if not, because they are unchanged or could not be fetched or built, the current
+// bangs stay in place and the next refresh fetches them again.
+bool refreshBangDataFromUrl(const std::string &url, const std::string &customBangsPath);
+
+// Loads the URL bangs saved by saveBangSnapshot in place of loadBangDataFromUrl, including the validators a refresh
+// needs to skip downloading them again. Returns false if there is no usable snapshot at path.
+bool loadBangDataFromSnapshot(const std::string &path);
+
+// Loads the bangs in a table restored from somewhere other than the URL as if they had come from it, validators
+// describing the copy they were built from
+void loadBangDataFromTable(std::unique_ptr<BangTable> table, const HttpValidators &validators);
+
+// Saves the bangs last loaded from the URL (not the custom ones) to path for loadBangDataFromSnapshot
+bool saveBangSnapshot(const std::string &path);
 std::string getCustomBangsFilePath();
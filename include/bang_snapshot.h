@@ -0,0 +1,22 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "bang_table.h"
+#include "http_client.h"
+
+// Binary image of a BangTable that a restart maps and restores in milliseconds, without the network, simdjson or
+// rebuilding the hash. Laid out as a header, the table's pilots and slots exactly as they are in memory, one
+// fixed-size record per bang (in slot order) and an arena holding every string, compiled redirect templates
+// included. Records point into the arena by offset and length. Only meant to be read back on the machine that
+// wrote it: the byte order and record layout are checked, not converted.
+
+// Writes table and the validators of the data it was built from to path, replacing it atomically (through a
+// temporary file and a rename), so a reader never sees half a snapshot. The file and then its directory are synced, so
+// a crash right after leaves the old snapshot or the whole new one. Returns false if it could not be written.
+bool writeBangSnapshot(const std::string &path, const BangTable &table, const HttpValidators &validators);
+
+// Maps path and restores the table and validators saved there. Returns nullptr, leaving validators untouched, if
+// there is no snapshot or it is truncated, corrupt or from another version.
+std::unique_ptr<BangTable> readBangSnapshot(const std::string &path, HttpValidators &validators);
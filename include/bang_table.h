@@ -0,0 +1,92 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+#include "bang.h"
+
+struct HttpValidators;
+
+// Longest trigger (including the '!') stored inline in its slot; longer ones are compared against Bang::trigger
+constexpr size_t MAX_INLINE_TRIGGER = 15;
+
+// Trigger bytes zero-padded to 15, with the length in the last byte (LONG_TRIGGER for triggers that do not fit)
+struct alignas(16) BangSlot {
+    unsigned char bytes[16];
+};
+
+// Immutable lookup structure over a set of bangs, built anew whenever bangs are loaded. A PTHash-style minimal perfect hash
+// maps every trigger to its own slot: one hash picks a bucket, the bucket's pilot moves the hash to a slot, and a
+// single 16-byte compare against the inline key decides hit or miss. Bangs are stored in slot order.
+class BangTable {
+public:
+    void build(const absl::flat_hash_map<std::string, Bang> &bangs);
+
+    [[nodiscard]] const Bang *find(std::string_view trigger) const;
+
+    [[nodiscard]] size_t size() const { return m_bangs.size(); }
+
+    // Every bang, in slot order
+    [[nodiscard]] const std::vector<Bang> &bangs() const { return m_bangs; }
+
+    // Longest head plus tail over every bang's redirect and domain redirect
+    [[nodiscard]] size_t maxRedirectSize() const { return m_maxRedirectSize; }
+
+private:
+    // Snapshots and the built-in table store the hash index as is, so restoring a table skips the build
+    friend bool writeBangSnapshot(const std::string &path, const BangTable &table, const HttpValidators &validators);
+
+    friend std::unique_ptr<BangTable> readBangSnapshot(const std::string &path, HttpValidators &validators);
+
+    friend void writeEmbeddedBangTable(std::ostream &out, const BangTable &table, std::string_view source);
+
+    friend std::unique_ptr<BangTable> embeddedBangTable();
+
+    [[nodiscard]] size_t bucketOf(uint64_t hash) const;
+
+    [[nodiscard]] size_t slotOf(uint64_t hash) const;
+
+    uint64_t m_seed = 0;
+    size_t m_buckets = 0;
+    size_t m_maxRedirectSize = 0;
+    size_t m_denseBuckets = 0; // The first buckets take most of the keys, which makes pilots easier to find
+    std::vector<uint64_t> m_pilots; // Per bucket, already hashed
+    std::vector<BangSlot> m_slots;
+    std::vector<Bang> m_bangs;
+};
+
+// The table every lookup goes through, never null. Reloading publishes a new table here and frees the old one only
+// once no reader can still be using it, so taking it is a single acquire load (a plain move on x86-64).
+extern std::atomic<const BangTable *> PUBLISHED_BANG_TABLE;
+
+inline const BangTable &bangTable() {
+    return *PUBLISHED_BANG_TABLE.load(std::memory_order_acquire);
+}
+
+// At least the maxRedirectSize() of any table a lookup starting now can see. It only ever grows, and a wider table
+// is published one grace period after raising it, so a response sized with it fits whichever table it is rendered
+// from.
+size_t widestBangRedirect();
+
+// Publishes table and frees the one it replaces after a grace period: once every registered reader has been offline
+// since the swap. Returns when the old table is gone.
+void publishBangTable(std::unique_ptr<const BangTable> table);
+
+// Builds a table from allBangs() and publishes it; the loaders call this after every successful load. Returns false,
+// leaving the current table in place, if no table could be built.
+bool rebuildBangTable();
+
+// Reader side of reloading (quiescent-state-based reclamation). A thread that serves lookups while a reload may run
+// registers once and starts out offline. While online it may hold on to the table and its Bangs; going offline, e.g.
+// before blocking for I/O, promises it holds nothing, and a reload waits for that before freeing a table. Neither
+// call is an atomic read-modify-write, and lookups themselves take part in none of this. Threads that never register
+// must not look anything up while a reload runs.
+void registerBangTableReader();
+
+void bangTableOnline();
+
+void bangTableOffline();
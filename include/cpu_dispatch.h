@@ -0,0 +1,49 @@
+#pragma once
+
+#include <optional>
+#include <string_view>
+
+// Instruction set levels the SIMD kernels are built for, narrowest first. Every binary carries all of them (only
+// Scalar off x86-64), and the widest one the CPU supports is picked at startup.
+enum class SimdTier {
+    Scalar,
+    SSE42, // SSE4.2 and POPCNT
+    AVX2, // AVX2, BMI1 and BMI2
+    AVX512, // AVX-512 BW, VBMI and VBMI2 (Ice Lake, Zen 4 and later)
+};
+
+// Widest tier this CPU and OS support, from cpuid
+SimdTier detectSimdTier();
+
+// Tier the kernels currently run at; detectSimdTier() unless forced with setSimdTier
+SimdTier activeSimdTier();
+
+// Forces the kernels to tier, for comparing tiers or working around one. Returns false, leaving the tier unchanged,
+// if the CPU does not support it. Call before starting any worker.
+bool setSimdTier(SimdTier tier);
+
+std::string_view simdTierName(SimdTier tier);
+
+// Inverse of simdTierName: "scalar", "sse4.2", "avx2" or "avx512"
+std::optional<SimdTier> parseSimdTier(std::string_view name);
+
+// For sources that compile their kernels once per tier (url_kernels.inc, http_parser_kernels.inc): the tiers as
+// numbers the preprocessor can compare, the instruction sets of each, and pragmas that enable a tier's instruction
+// sets for every function between SIMD_TARGET(SIMD_ISA_...) and SIMD_TARGET_END
+#define SIMD_TIER_SCALAR 0
+#define SIMD_TIER_SSE42 1
+#define SIMD_TIER_AVX2 2
+#define SIMD_TIER_AVX512 3
+
+#define SIMD_ISA_SSE42 "sse4.2,popcnt"
+#define SIMD_ISA_AVX2 "avx2,bmi,bmi2,popcnt"
+#define SIMD_ISA_AVX512 "avx512f,avx512bw,avx512vbmi,avx512vbmi2,avx2,bmi,bmi2,popcnt"
+
+#define SIMD_PRAGMA(x) _Pragma(#x)
+#if defined(__clang__)
+#define SIMD_TARGET(isa) SIMD_PRAGMA(clang attribute push(__attribute__((target(isa))), apply_to = function))
+#define SIMD_TARGET_END SIMD_PRAGMA(clang attribute pop)
+#else
+#define SIMD_TARGET(isa) SIMD_PRAGMA(GCC push_options) SIMD_PRAGMA(GCC target(isa))
+#define SIMD_TARGET_END SIMD_PRAGMA(GCC pop_options)
+#endif
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <span>
+#include <string_view>
+
+#include "bang_table.h"
+
+// A bang as compiled into the binary, redirect templates included. Optional strings are absent when their data() is
+// null, which a present but empty string never is.
+struct EmbeddedBang {
+    std::string_view trigger;
+    std::string_view url_template;
+    std::string_view domain;
+    std::string_view short_name;
+    std::string_view subcategory;
+    std::string_view redirectHead;
+    std::string_view redirectTail;
+    std::string_view domainRedirectHead;
+    std::string_view domainRedirectTail;
+    uint64_t relevance;
+    bool hasRelevance;
+    int8_t category; // -1 if none
+};
+
+// A BangTable that bangcodegen built at compile time, laid out as the table keeps it: bangs in slot order
+struct EmbeddedBangTable {
+    std::string_view source; // File name of the bangs it was built from
+    uint64_t seed;
+    size_t buckets;
+    size_t denseBuckets;
+    size_t maxRedirectSize;
+    std::span<const uint64_t> pilots;
+    std::span<const BangSlot> slots;
+    std::span<const EmbeddedBang> bangs;
+};
+
+// Defined in the source bangcodegen writes at build time
+extern const EmbeddedBangTable EMBEDDED_BANG_TABLE;
+
+// Writes a C++ source defining EMBEDDED_BANG_TABLE as table, built from the bangs in the file named source
+void writeEmbeddedBangTable(std::ostream &out, const BangTable &table, std::string_view source);
+
+// The built-in bangs as a table, restored without parsing or hashing anything; nullptr if none were built in
+std::unique_ptr<BangTable> embeddedBangTable();
+
+// Loads the built-in bangs in place of loadBangDataFromUrl, so there is something to serve before the network is
+// reached. They come with no validators: the first refresh downloads the bangs in full. Returns false if there are
+// none.
+bool loadEmbeddedBangData();
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <string_view>
+
+// Validators of a previously fetched copy, sent back so the server can answer 304 Not Modified when it is current
+struct HttpValidators {
+    std::string etag;
+    std::string lastModified;
+};
+
+struct HttpResponse {
+    int status = 0; // 0 if no complete response was received
+    std::string body; // With chunked transfer and gzip/deflate content encoding already undone
+    HttpValidators validators;
+};
+
+// Blocking HTTP/1.1 GET for background work such as refreshing the bangs; never call it from a worker. Resolves the
+// host with getaddrinfo (IPv4 or IPv6), uses the port in the URL if there is one, asks for gzip and accepts
+// Content-Length, chunked and close-delimited bodies, binary-safe. Non-empty validators make it a conditional
+// request. There is no TLS: an https URL is fetched over plain HTTP (port 80 unless it names one). Gives up when
+// connecting or any single read or write takes longer than timeout.
+HttpResponse httpGet(std::string_view url, std::string_view accept, const HttpValidators &validators = {},
+                     std::chrono::milliseconds timeout = std::chrono::seconds(10));
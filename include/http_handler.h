@@ -6,21 +6,43 @@
 enum class HttpStatus {
     OK = 200,
     FOUND = 302,
-    NOT_FOUND = 404
+    NOT_FOUND = 404,
+    URI_TOO_LONG = 414,
+    REQUEST_HEADER_FIELDS_TOO_LARGE = 431,
+    SERVICE_UNAVAILABLE = 503
 };
 
 constexpr std::string_view CONTENT_TYPE_HTML = "text/html";
 constexpr std::string_view CONTENT_TYPE_XML = "application/opensearchdescription+xml";
 constexpr std::string_view CONTENT_TYPE_JSON = "application/json";
 
+constexpr std::string_view CONNECTION_KEEP_ALIVE = "Connection: keep-alive\r\n\r\n";
+constexpr std::string_view CONNECTION_CLOSE = "Connection: close\r\n\r\n";
+
+// A redirect target split around its "{{{s}}}" query placeholder once, at load time, with the status line and
+// Location header folded into the head and the rest of the headers into the tail. A redirect response is then
+// head + encoded query + tail + connection header, with nothing left to search for per request.
+struct RedirectTemplate {
+    std::string head;
+    std::string tail;
+};
+
+// Templates without a placeholder get the query appended, matching how DuckDuckGo treats them
+RedirectTemplate compileRedirectTemplate(std::string_view searchUrl);
+
+// Fully rendered redirect to a fixed URL, e.g. a bang's domain when there is no query to search for
+RedirectTemplate renderFixedRedirect(std::string_view url);
+
 extern const std::string_view HOME_PAGE_HTML;
 extern const std::string_view OPENSEARCH_XML;
 
 std::string_view createHttpResponse(HttpStatus status, std::string_view contentType, 
-                                   std::string_view body, char* buffer);
+                                   std::string_view body, char* buffer, bool keepAlive = false);
 
-std::string_view createRedirectResponse(std::string_view searchUrl, std::string_view encodedQuery, char* buffer);
+std::string_view createRedirectResponse(const RedirectTemplate &redirect, std::string_view encodedQuery, char *buffer,
+                                        bool keepAlive = false);
 
-std::string_view extractPath(std::string_view requestData);
+// Upper bounds on the bytes the two functions above write, so callers can check the buffer before building
+size_t maxHttpResponseSize(std::string_view contentType, std::string_view body);
 
-std::string makeHttpRequest(const std::string &url, const std::string &acceptType = "application/json");
\ No newline at end of file
+size_t maxRedirectResponseSize(const RedirectTemplate &redirect, std::string_view encodedQuery);
\ No newline at end of file
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <string_view>
+
+// Views into the buffer a request was parsed from; they are only valid as long as that buffer is
+struct HttpRequest {
+    std::string_view method;
+    std::string_view target; // Path plus query string, as sent
+    std::string_view path;
+    std::string_view query; // Everything after the '?', empty if there is none
+    std::string_view version;
+
+    // The only headers the server looks at, empty if absent
+    std::string_view connection;
+    std::string_view host;
+    std::string_view acceptEncoding;
+    std::string_view ifNoneMatch;
+
+    size_t length = 0; // Bytes up to and including the blank line ending the headers
+};
+
+// Parses the request at the start of data in a single pass over the request line and headers. Returns the request's
+// length, or npos if the blank line ending its headers has not arrived yet.
+size_t parseHttpRequest(std::string_view data, HttpRequest &request);
+
+// Length of the request at the start of data up to and including the blank line ending its headers, or npos if that
+// has not arrived yet. Only looks at bytes from offset from on (less the two a line ending may straddle), so a request
+// arriving piece by piece is searched once in all rather than once per piece.
+size_t findHeadersEnd(std::string_view data, size_t from);
+
+// Whether the connection should persist after answering this request (HTTP version + Connection header)
+bool isKeepAlive(const HttpRequest &request);
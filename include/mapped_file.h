@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Read-only mapping of a whole file, prefaulted, and unmapped again when it goes out of scope. padding zero bytes
+// past the end stay readable, so parsers that read ahead (simdjson wants SIMDJSON_PADDING) can work on it in place:
+// the file is mapped over an anonymous mapping that is that much longer.
+class MappedFile {
+public:
+    explicit MappedFile(const std::string &path, const size_t padding = 0) {
+        const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return;
+
+        struct stat info{};
+        if (fstat(fd, &info) == 0) {
+            const size_t size = info.st_size;
+            void *data;
+            if (padding == 0) {
+                data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+            } else if ((data = mmap(nullptr, size + padding, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0)) !=
+                       MAP_FAILED && size > 0 &&
+                       mmap(data, size, PROT_READ, MAP_PRIVATE | MAP_FIXED | MAP_POPULATE, fd, 0) == MAP_FAILED) {
+                munmap(data, size + padding);
+                data = MAP_FAILED;
+            }
+            if (data != MAP_FAILED) {
+                m_data = static_cast<const char *>(data);
+                m_size = size;
+                m_mappedSize = size + padding;
+            }
+        }
+        close(fd);
+    }
+
+    ~MappedFile() {
+        if (m_data) munmap(const_cast<char *>(m_data), m_mappedSize);
+    }
+
+    MappedFile(const MappedFile &) = delete;
+
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    // Null if the file could not be opened or mapped (or is empty and there is no padding)
+    [[nodiscard]] const char *data() const { return m_data; }
+    [[nodiscard]] size_t size() const { return m_size; }
+
+private:
+    const char *m_data = nullptr;
+    size_t m_size = 0;
+    size_t m_mappedSize = 0;
+};
@@ -1,66 +1,296 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <vector>
 #include <mutex>
 
+#include <sys/mman.h>
+
+// Threads that get a cache of their own in every MemoryPool; any beyond that go straight to the shared free list
+constexpr int MAX_THREAD_CACHES = 64;
+
+// The calling thread's cache slot, the same in every pool, or -1 while all slots are taken. A thread hands its slot
+// back when it exits, and the next thread to take it inherits whatever was left in the caches.
+inline int threadCacheSlot() {
+    static std::atomic<uint64_t> takenSlots{0};
+
+    struct Slot {
+        int index = -1;
+
+        Slot() {
+            uint64_t taken = takenSlots.load(std::memory_order_relaxed);
+            while (~taken) {
+                const int free = __builtin_ctzll(~taken);
+                if (takenSlots.compare_exchange_weak(taken, taken | 1ULL << free, std::memory_order_acquire,
+                                                     std::memory_order_relaxed)) {
+                    index = free;
+                    break;
+                }
+            }
+        }
+
+        ~Slot() {
+            if (index >= 0) takenSlots.fetch_and(~(1ULL << index), std::memory_order_release);
+        }
+    };
+
+    static thread_local const Slot slot;
+    return slot.index;
+}
+
+constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+// Memory mapped by mapHugePages
+struct HugePageRegion {
+    char *base = nullptr;
+    size_t size = 0;
+    bool hugeTlb = false; // Explicit huge pages rather than a transparent huge page hint
+    bool locked = false;
+
+    [[nodiscard]] bool contains(const char *pointer) const { return pointer >= base && pointer < base + size; }
+};
+
+// Anonymous mapping of size bytes (a multiple of HUGE_PAGE_SIZE) on huge pages: explicit 2 MiB pages from the
+// hugetlb pool when the administrator has set some aside, transparent huge pages otherwise. Every page is faulted in
+// before returning and, with lockPages, locked into RAM. base is nullptr if not even regular pages could be mapped.
+inline HugePageRegion mapHugePages(const size_t size, const bool lockPages) {
+    HugePageRegion region{.size = size};
+
+    // Asks for 2 MiB pages (log2 in the size bits) even where the default huge page size is 1 GiB
+    void *base = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | 21 << MAP_HUGE_SHIFT, -1, 0);
+    region.hugeTlb = base != MAP_FAILED;
+    if (!region.hugeTlb) {
+        base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (base == MAP_FAILED) return {};
+        // Only a hint: without THP enabled the region simply stays on 4 KiB pages
+        madvise(base, size, MADV_HUGEPAGE);
+    }
+    region.base = static_cast<char *>(base);
+
+    // Fault everything in now rather than on the first requests; after the madvise, so THP can back it
+    for (size_t offset = 0; offset < size; offset += 4096) {
+        region.base[offset] = 0;
+    }
+    region.locked = lockPages && mlock(region.base, size) == 0;
+    return region;
+}
+
+// Fixed-size buffers with O(1) acquire and release. Each thread works from its own cache of free buffers and only
+// touches the shared free list to move a whole batch in or out: a lock-free stack of batches, each batch linked
+// through the free buffers themselves. The mutex is only taken to allocate more buffers.
 class alignas(64) MemoryPool {
 public:
     explicit MemoryPool(const size_t bufferSize, const size_t initialCapacity = 64)
-        : m_bufferSize(bufferSize), m_capacity(initialCapacity) {
-        m_blocks.reserve(initialCapacity);
-        for (size_t i = 0; i < initialCapacity; ++i) {
-            m_blocks.push_back(new char[bufferSize]);
-            m_freeList.push_back(i);
-        }
+        : m_caches(std::make_unique<ThreadCache[]>(MAX_THREAD_CACHES)),
+          m_bufferSize(std::max(bufferSize, sizeof(FreeBlock))), m_capacity(0) {
+        reserve(initialCapacity);
     }
 
     ~MemoryPool() {
         for (const auto *block: m_blocks) {
-            delete[] block;
+            if (!m_arena.contains(block)) delete[] block;
         }
+        if (m_arena.base) munmap(m_arena.base, m_arena.size);
     }
 
+    MemoryPool(const MemoryPool &) = delete;
+
+    MemoryPool &operator=(const MemoryPool &) = delete;
+
     char *acquire() {
-        std::lock_guard lock(m_mutex);
-        if (m_freeList.empty()) {
-            // Grow pool by 50% when out of buffers
-            const size_t newBlocks = m_capacity / 2 + 1;
-            const size_t oldSize = m_blocks.size();
-            m_blocks.reserve(oldSize + newBlocks);
-            m_freeList.reserve(newBlocks);
-
-            for (size_t i = 0; i < newBlocks; ++i) {
-                m_blocks.push_back(new char[m_bufferSize]);
-                m_freeList.push_back(oldSize + i);
-            }
+        const int slot = threadCacheSlot();
+        ThreadCache *cache = slot >= 0 ? &m_caches[slot] : nullptr;
+        if (cache && cache->head) {
+            FreeBlock *block = cache->head;
+            cache->head = block->next;
+            --cache->count;
+            return reinterpret_cast<char *>(block);
+        }
 
-            m_capacity += newBlocks;
+        FreeBlock *batch;
+        while (!(batch = popBatch())) {
+            grow();
         }
 
-        const size_t index = m_freeList.back();
-        m_freeList.pop_back();
-        return m_blocks[index];
+        // The rest of the batch refills the cache
+        if (FreeBlock *rest = batch->next) {
+            if (cache) {
+                cache->head = rest;
+                cache->count = batch->count - 1;
+            } else {
+                rest->count = batch->count - 1;
+                pushBatch(rest);
+            }
+        }
+        return reinterpret_cast<char *>(batch);
     }
 
     void release(const char *buffer) {
         if (!buffer) return;
 
-        std::lock_guard lock(m_mutex);
-        for (size_t i = 0; i < m_blocks.size(); ++i) {
-            if (m_blocks[i] == buffer) {
-                m_freeList.push_back(i);
-                return;
+        auto *block = reinterpret_cast<FreeBlock *>(const_cast<char *>(buffer));
+        const int slot = threadCacheSlot();
+        if (slot < 0) {
+            block->next = nullptr;
+            block->count = 1;
+            pushBatch(block);
+            return;
+        }
+
+        ThreadCache &cache = m_caches[slot];
+        block->next = cache.head;
+        cache.head = block;
+        if (++cache.count == 2 * BATCH_SIZE) {
+            // Keep the most recently released half, which is likelier to still be in cache, and share the rest
+            FreeBlock *last = cache.head;
+            for (size_t i = 1; i < BATCH_SIZE; ++i) {
+                last = last->next;
             }
+            FreeBlock *batch = last->next;
+            last->next = nullptr;
+            batch->count = BATCH_SIZE;
+            pushBatch(batch);
+            cache.count = BATCH_SIZE;
+        }
+    }
+
+    // Grows the pool to at least count blocks up front, e.g. before registering them with io_uring
+    void reserve(const size_t count) {
+        std::lock_guard lock(m_growMutex);
+        const size_t oldSize = m_blocks.size();
+        if (count <= oldSize) return;
+
+        allocate(count - oldSize);
+        m_capacity = count;
+    }
+
+    // Adds at least count blocks carved from one contiguous huge page region instead of separate heap allocations,
+    // so the whole set costs a handful of TLB entries and can be registered with io_uring as a single buffer. Arena
+    // blocks are handed out before any heap block; growth past them falls back to the heap. Only one arena per pool:
+    // returns false if there already is one or the region could not be mapped.
+    bool reserveArena(const size_t count, const bool lockPages = false) {
+        std::lock_guard lock(m_growMutex);
+        if (m_arena.base) return false;
+
+        // Slots stay cache line aligned; whatever rounding up to whole huge pages leaves over becomes extra slots
+        const size_t stride = (m_bufferSize + 63) & ~size_t{63};
+        const size_t size = (count * stride + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+        m_arena = mapHugePages(size, lockPages);
+        if (!m_arena.base) return false;
+
+        const size_t slots = size / stride;
+        const size_t oldSize = m_blocks.size();
+        m_blocks.reserve(oldSize + slots);
+        for (size_t i = 0; i < slots; ++i) {
+            m_blocks.push_back(m_arena.base + i * stride);
         }
+        shareBatches(oldSize);
+        m_capacity = m_blocks.size();
+        return true;
+    }
+
+    // The region reserveArena mapped, empty without one
+    [[nodiscard]] const HugePageRegion &arena() const { return m_arena; }
+
+    // Snapshot of every block allocated so far; blocks added by later growth are not included
+    [[nodiscard]] std::vector<char *> blocks() {
+        std::lock_guard lock(m_growMutex);
+        return m_blocks;
     }
 
     [[nodiscard]] size_t bufferSize() const { return m_bufferSize; }
 
 private:
-    std::mutex m_mutex;
+    // Header written into a free buffer. The first buffer of a batch also holds the batch size and the next batch.
+    struct FreeBlock {
+        FreeBlock *next;
+        FreeBlock *nextBatch;
+        size_t count;
+    };
+
+    struct alignas(64) ThreadCache {
+        FreeBlock *head = nullptr;
+        size_t count = 0;
+    };
+
+    static constexpr size_t BATCH_SIZE = 16;
+
+    // m_batches packs the top batch's address into the low 48 bits and a counter, bumped on every change, into the
+    // high 16, so a pop that raced with a pop and push of the same block fails its compare-exchange (ABA)
+    static constexpr int POINTER_BITS = 48;
+    static constexpr uint64_t POINTER_MASK = (1ULL << POINTER_BITS) - 1;
+
+    static FreeBlock *pointerOf(const uint64_t head) { return reinterpret_cast<FreeBlock *>(head & POINTER_MASK); }
+
+    static uint64_t nextHead(const uint64_t head, const FreeBlock *top) {
+        return ((head >> POINTER_BITS) + 1) << POINTER_BITS | reinterpret_cast<uintptr_t>(top);
+    }
+
+    void pushBatch(FreeBlock *batch) {
+        uint64_t head = m_batches.load(std::memory_order_relaxed);
+        do {
+            batch->nextBatch = pointerOf(head);
+        } while (!m_batches.compare_exchange_weak(head, nextHead(head, batch), std::memory_order_release,
+                                                  std::memory_order_relaxed));
+    }
+
+    FreeBlock *popBatch() {
+        uint64_t head = m_batches.load(std::memory_order_acquire);
+        while (FreeBlock *top = pointerOf(head)) {
+            // top may already be taken and written to by another thread; then the counter has moved on and the
+            // exchange fails. Buffers are only freed with the pool, so the read itself is always safe.
+            if (m_batches.compare_exchange_weak(head, nextHead(head, top->nextBatch), std::memory_order_acquire,
+                                                std::memory_order_acquire)) {
+                return top;
+            }
+        }
+        return nullptr;
+    }
+
+    // Grow pool by 50% when out of buffers, unless another thread just did
+    void grow() {
+        std::lock_guard lock(m_growMutex);
+        if (pointerOf(m_batches.load(std::memory_order_acquire))) return;
+
+        const size_t newBlocks = m_capacity / 2 + 1;
+        allocate(newBlocks);
+        m_capacity += newBlocks;
+    }
+
+    // Allocates count buffers and shares them in batches; the caller holds m_growMutex
+    void allocate(const size_t count) {
+        const size_t oldSize = m_blocks.size();
+        m_blocks.reserve(oldSize + count);
+        for (size_t i = 0; i < count; ++i) {
+            m_blocks.push_back(new char[m_bufferSize]);
+        }
+        shareBatches(oldSize);
+    }
+
+    // Links the blocks from m_blocks[from] on into batches and shares them; the caller holds m_growMutex
+    void shareBatches(const size_t from) {
+        for (size_t first = from; first < m_blocks.size(); first += BATCH_SIZE) {
+            const size_t batchSize = std::min(BATCH_SIZE, m_blocks.size() - first);
+            for (size_t i = 0; i < batchSize; ++i) {
+                reinterpret_cast<FreeBlock *>(m_blocks[first + i])->next =
+                        i + 1 < batchSize ? reinterpret_cast<FreeBlock *>(m_blocks[first + i + 1]) : nullptr;
+            }
+            auto *batch = reinterpret_cast<FreeBlock *>(m_blocks[first]);
+            batch->count = batchSize;
+            pushBatch(batch);
+        }
+    }
+
+    alignas(64) std::atomic<uint64_t> m_batches{0};
+    alignas(64) std::unique_ptr<ThreadCache[]> m_caches;
+    std::mutex m_growMutex;
     std::vector<char *> m_blocks;
-    std::vector<size_t> m_freeList;
+    HugePageRegion m_arena;
     size_t m_bufferSize;
     size_t m_capacity;
 };
@@ -114,11 +344,6 @@ inline MemoryPool &getRequestPool() {
     return requestPool;
 }
 
-inline MemoryPool &getEncodePool() {
-    static MemoryPool encodePool(12288); // For URL encoding (3x request size)
-    return encodePool;
-}
-
 inline MemoryPool &getRedirectPool() {
     static MemoryPool redirectPool(4096); // For response buffers
     return redirectPool;
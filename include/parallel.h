@@ -0,0 +1,45 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <thread>
+#include <vector>
+
+// Calls body(begin, end) on contiguous chunks covering [0, count), one per core but none smaller than minChunk, and
+// returns once all of them are done. The calling thread takes the first chunk. Spawns its threads anew every time,
+// so it is meant for loading, not for anything on the request path. If body throws, the exception of the first chunk
+// that threw is rethrown here once every chunk has finished.
+template<typename Body>
+void parallelChunks(const size_t count, const size_t minChunk, Body &&body) {
+    const size_t cores = std::max(1u, std::thread::hardware_concurrency());
+    const size_t chunks = std::clamp<size_t>(count / std::max<size_t>(minChunk, 1), 1, cores);
+    if (chunks == 1) {
+        body(size_t{0}, count);
+        return;
+    }
+
+    const size_t chunkSize = (count + chunks - 1) / chunks;
+    std::vector<std::exception_ptr> errors(chunks);
+    const auto run = [&body, &errors](const size_t chunk, const size_t begin, const size_t end) {
+        try {
+            body(begin, end);
+        } catch (...) {
+            errors[chunk] = std::current_exception();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(chunks - 1);
+    for (size_t chunk = 1, begin = chunkSize; begin < count; ++chunk, begin += chunkSize) {
+        threads.emplace_back(run, chunk, begin, std::min(count, begin + chunkSize));
+    }
+    run(0, 0, chunkSize);
+    for (std::thread &thread: threads) {
+        thread.join();
+    }
+
+    for (const std::exception_ptr &error: errors) {
+        if (error) std::rethrow_exception(error);
+    }
+}
@@ -4,6 +4,10 @@
 #include <utility>
 #include <thread>
 
+#include "http_handler.h"
+
+struct Bang;
+
 constexpr std::string_view QUERY_PARAM = "?q=";
 constexpr std::string_view DEFAULT_SEARCH_URL = "https://www.google.com/search?q=";
 
@@ -75,16 +79,6 @@ public:
         static thread_local AlignedBuffer encodeBuffer(4096);
         return encodeBuffer;
     }
-
-    static AlignedBuffer &getTempBuffer() {
-        static thread_local AlignedBuffer tempBuffer(4096);
-        return tempBuffer;
-    }
-
-    static AlignedBuffer &getResponseBuffer() {
-        static thread_local AlignedBuffer responseBuffer(8192);
-        return responseBuffer;
-    }
 };
 
 struct alignas(64) HexTables {
@@ -123,7 +117,7 @@ struct alignas(64) HexTables {
 };
 
 struct alignas(64) SafeChars {
-    constexpr SafeChars() : safe{}, safeMap{} {
+    constexpr SafeChars() : safe{}, safeMap{}, lowNibbleClass{}, highNibbleClass{} {
         // Fill traditional safe character array
         for (int i = 'a'; i <= 'z'; i++) safe[i] = true;
         for (int i = 'A'; i <= 'Z'; i++) safe[i] = true;
@@ -154,13 +148,23 @@ struct alignas(64) SafeChars {
         }
 
         // Special chars: bit 3
-        for (constexpr char special[] = "-_.~!"; const char c: special) {
+        for (const char c: std::string_view("-_.~!")) {
             safeMap[static_cast<unsigned char>(c) & 0x7F] |= 8;
         }
+
+        // Nibble classes for SIMD lookups: c is safe when lowNibbleClass[c & 15] & highNibbleClass[c >> 4] != 0
+        for (int i = 0; i < 128; i++) {
+            if (safeMap[i]) lowNibbleClass[i & 15] |= 1 << (i >> 4);
+        }
+        for (int i = 0; i < 8; i++) {
+            highNibbleClass[i] = 1 << i;
+        }
     }
 
     alignas(64) bool safe[256];
     alignas(64) unsigned char safeMap[128];
+    alignas(16) unsigned char lowNibbleClass[16];
+    alignas(16) unsigned char highNibbleClass[16];
 };
 
 inline const HexTables &getHexTables() {
@@ -177,5 +181,29 @@ size_t urlDecode(std::string_view str, char *buffer);
 
 size_t urlEncode(std::string_view str, char *buffer);
 
-std::pair<std::string_view, std::string_view> processQuery(std::string_view url, char *decode_buffer = nullptr,
-                                                           char *encode_buffer = nullptr);
+// Offset of the first '!' in buffer that starts a known bang (at the start or after a space), SIZE_MAX if none. The
+// bang it starts goes to *bang if given, so callers need not look it up a second time.
+size_t findFirstValidBangPosition(const char *buffer, size_t length, const Bang **bang = nullptr);
+
+// urlDecode, urlEncode, findFirstValidBangPosition and renderSearchResponse run the kernels of activeSimdTier()
+
+// Picks the redirect for a search and %-encodes the query to fill into it. The template belongs to bangTable() (or is
+// the static default) and stays valid until the next reload, the encoded query lives in encode_buffer.
+std::pair<const RedirectTemplate *, std::string_view> processQuery(std::string_view url, char *decode_buffer = nullptr,
+                                                                   char *encode_buffer = nullptr);
+
+// Same as processQuery, for a query string already split off the request target (everything after the '?')
+std::pair<const RedirectTemplate *, std::string_view> processSearchQuery(std::string_view queryString,
+                                                                         char *decode_buffer = nullptr,
+                                                                         char *encode_buffer = nullptr);
+
+// Upper bound on the response renderSearchResponse writes for queryString, whichever redirect it picks
+size_t maxSearchResponseSize(std::string_view queryString);
+
+// Fused search path: decodes the query, finds the bang and writes the re-encoded query straight into the complete
+// redirect response in buffer, in a single pass and without intermediate buffers. buffer must hold
+// maxSearchResponseSize(queryString) bytes. Returns the response length.
+size_t renderSearchResponse(std::string_view queryString, char *buffer, bool keepAlive = false);
+
+// Same as renderSearchResponse, for a request target (buffer must hold maxSearchResponseSize(url) bytes)
+size_t renderQueryResponse(std::string_view url, char *buffer, bool keepAlive = false);
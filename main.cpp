@@ -2,148 +2,507 @@
 #include <string>
 #include <string_view>
 #include <chrono>
+#include <algorithm>
+#include <charconv>
 #include <cstring>
 #include <utility>
 #include <vector>
+#include <deque>
 #include <thread>
+#include <cerrno>
+#include <csignal>
+#include <filesystem>
+#include <optional>
 
+#include <pthread.h>
+#include <sched.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/signalfd.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <netinet/tcp.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <liburing.h>
+#include <sys/uio.h>
+#include <absl/container/flat_hash_map.h>
 
 #include "include/bang.h"
+#include "include/bang_table.h"
+#include "include/embedded_bangs.h"
 #include "include/memory_pool.h"
 #include "include/url_processing.h"
+#include "include/cpu_dispatch.h"
 #include "include/http_handler.h"
+#include "include/http_parser.h"
 
 constexpr int PORT = 3000;
-constexpr int BACKLOG = 5;
+// Pending connections each listener queues before multishot accept drains them; the kernel caps it at
+// net.core.somaxconn, so bursts are limited by that sysctl rather than dropped here
+constexpr int BACKLOG = SOMAXCONN;
 
 constexpr size_t QUEUE_DEPTH = 256;
 constexpr size_t REQUEST_BUFFER_SIZE = 4096;
+constexpr unsigned BUFFER_RING_ENTRIES = 512; // Per worker, must be a power of two
+constexpr int BUFFER_GROUP_ID = 0;
+constexpr size_t RESPONSE_BUFFER_SIZE = 4096;
+// Requests may grow past REQUEST_BUFFER_SIZE up to this many bytes (headers included) unless --max-request-size
+// says otherwise; long pasted queries are what pushes them there
+constexpr size_t DEFAULT_MAX_REQUEST_SIZE = 64 * 1024;
+// Room a spilled response keeps next to the fully %-encoded query (3x) for status line, headers and template
+constexpr size_t SPILL_RESPONSE_HEADROOM = 2048;
+// Spilled requests, and separately spilled responses, a worker holds at once. Further oversized requests are answered
+// with 503, so a few slow clients cannot make a worker hold more than this many blocks of either kind.
+constexpr size_t MAX_SPILL_BLOCKS = 16;
+// Seconds a connection may wait on its peer, for the rest of a request or for it to take a response, before it is
+// closed, unless --idle-timeout says otherwise. A once-a-second sweep checks it, so it fires up to a second late.
+constexpr int DEFAULT_IDLE_TIMEOUT = 30;
+// Registered I/O mode: size of each worker's direct descriptor table and number of pre-registered response buffers
+constexpr unsigned FIXED_FILE_TABLE_SIZE = 16384;
+constexpr size_t REGISTERED_RESPONSE_BUFFERS = 4096;
+// Huge page mode: request buffers carved from the request pool's arena (the response arena holds
+// REGISTERED_RESPONSE_BUFFERS). Most requests never leave the receive ring, so this one can be smaller.
+constexpr size_t ARENA_REQUEST_BUFFERS = 1024;
+// Where the bangs come from, and how often (in seconds) they are fetched again unless --refresh-interval says otherwise
+constexpr std::string_view DEFAULT_UPSTREAM_URL = "https://duckduckgo.com/bang.js";
+constexpr int DEFAULT_REFRESH_INTERVAL = 6 * 60 * 60;
+constexpr std::string_view DEFAULT_SNAPSHOT_PATH = "bangs.snapshot";
 constexpr char HTTP_SPACE = ' ';
 constexpr char HTTP_NL = '\n';
 constexpr char HTTP_CR = '\r';
 
-enum class ConnectionState {
+// Every SQE's user_data carries the operation and, for connections, the context's slab slot
+enum class Operation : uint8_t {
     ACCEPT,
+    READ,
+    WRITE,
+    CLOSE,
+    TICK, // The idle sweep's one-second timer
+    CANCEL // Cancelling an idle connection's recv or send
+};
+
+constexpr uint64_t makeUserData(const uint32_t slot, const Operation op) {
+    return static_cast<uint64_t>(slot) << 8 | static_cast<uint8_t>(op);
+}
+
+constexpr uint32_t userDataSlot(const uint64_t userData) { return static_cast<uint32_t>(userData >> 8); }
+constexpr Operation userDataOperation(const uint64_t userData) { return static_cast<Operation>(userData & 0xFF); }
+
+enum class ConnectionState {
     READ,
     PROCESS,
     WRITE,
     CLOSE
 };
 
+struct ServerOptions {
+    int workers = 1;
+    bool registeredIo = false; // Direct descriptors and registered response buffers
+    bool hugePages = false; // Receive rings and request and response pools carved from huge page arenas
+    bool lockPages = false; // mlock the arenas
+    size_t maxRequestSize = DEFAULT_MAX_REQUEST_SIZE;
+    int idleTimeout = DEFAULT_IDLE_TIMEOUT; // Seconds, 0 to never close idle connections
+    std::string upstreamUrl{DEFAULT_UPSTREAM_URL};
+    int refreshInterval = DEFAULT_REFRESH_INTERVAL; // Seconds, 0 to never refresh
+    std::string snapshotPath{DEFAULT_SNAPSHOT_PATH}; // Empty to neither read nor write a snapshot
+};
+
+// Per-worker blocks for the rare connection whose request outgrows the regular pooled buffers: request blocks that
+// carry a request of up to maxRequestSize bytes, and response blocks that answer one in one piece. They are taken
+// separately, a response block only once there is a response too large for a regular buffer, and at most
+// MAX_SPILL_BLOCKS of each kind at a time; acquire returns nullptr past that.
+class SpillPool {
+public:
+    explicit SpillPool(const size_t maxRequestSize)
+        : m_maxRequestSize(maxRequestSize),
+          m_requests(maxRequestSize + 1, 0),
+          m_responses(responseCapacity(), 0) {
+    }
+
+    char *acquireRequest() { return acquire(m_requests, m_requestsInUse); }
+
+    void releaseRequest(const char *block) { release(m_requests, m_requestsInUse, block); }
+
+    char *acquireResponse() { return acquire(m_responses, m_responsesInUse); }
+
+    void releaseResponse(const char *block) { release(m_responses, m_responsesInUse, block); }
+
+    [[nodiscard]] size_t maxRequestSize() const { return m_maxRequestSize; }
+
+    [[nodiscard]] size_t responseCapacity() const { return 3 * m_maxRequestSize + SPILL_RESPONSE_HEADROOM; }
+
+private:
+    static char *acquire(MemoryPool &pool, size_t &inUse) {
+        if (inUse == MAX_SPILL_BLOCKS) return nullptr;
+        ++inUse;
+        return pool.acquire();
+    }
+
+    static void release(MemoryPool &pool, size_t &inUse, const char *block) {
+        --inUse;
+        pool.release(block);
+    }
+
+    size_t m_maxRequestSize;
+    MemoryPool m_requests;
+    MemoryPool m_responses;
+    size_t m_requestsInUse = 0;
+    size_t m_responsesInUse = 0;
+};
+
+// Slab-resident connection state, reset for each new connection. Buffers are only held while a stage needs them: the
+// request buffer while a partial request is carried, the response buffer from processing until the response has
+// been sent, so idle and parked slots cost no buffer memory. The socket is always closed through the ring, never here.
 struct RequestContext {
-    int clientFd;
+    uint32_t slot;
+    int clientFd; // Index into the ring's fixed file table when fixedFile is set
+    bool fixedFile;
+    int responseBufferIndex; // Registered buffer index of response while it is being sent, -1 if not registered
     ConnectionState state;
 
-    char *requestBuffer;
-    char *decodeBuffer;
-    char *encodeBuffer;
-    char *responseBuffer;
+    char *requestBuffer; // Only held while a partial request is carried over between reads
+    char *responseBuffer; // Only held while a response is built or sent
+
+    SpillPool *spillPool;
+    char *spillRequestBuffer; // Only held while an oversized request is carried
+    char *spillResponseBuffer; // Only held while a response too large for responseBuffer is built or sent
+    // Where responses are built and sent from: responseBuffer, spillResponseBuffer, or nullptr if none
+    char *response;
 
     size_t bytesRead;
+    size_t headerScan; // Leading bytes of the carried request already searched for the end of its headers
     size_t responseLen;
+    size_t bytesSent;
+    bool keepAlive;
+    uint32_t lastActive; // Sweep tick at which the connection was accepted, last answered a request or last sent bytes
 
-    RequestContext()
-        : clientFd(-1),
-          state(ConnectionState::ACCEPT),
-          requestBuffer(getRequestPool().acquire()),
-          decodeBuffer(getRequestPool().acquire()),
-          encodeBuffer(getEncodePool().acquire()),
-          responseBuffer(getRedirectPool().acquire()),
+    RequestContext(const uint32_t slotIndex, SpillPool &spill)
+        : slot(slotIndex),
+          clientFd(-1),
+          fixedFile(false),
+          responseBufferIndex(-1),
+          state(ConnectionState::CLOSE),
+          requestBuffer(nullptr),
+          responseBuffer(nullptr),
+          spillPool(&spill),
+          spillRequestBuffer(nullptr),
+          spillResponseBuffer(nullptr),
+          response(nullptr),
           bytesRead(0),
-          responseLen(0) {
+          headerScan(0),
+          responseLen(0),
+          bytesSent(0),
+          keepAlive(true),
+          lastActive(0) {
     }
 
     ~RequestContext() {
-        if (requestBuffer) getRequestPool().release(requestBuffer);
-        if (decodeBuffer) getRequestPool().release(decodeBuffer);
-        if (encodeBuffer) getEncodePool().release(encodeBuffer);
+        if (requestBuffer && requestBuffer != spillRequestBuffer) getRequestPool().release(requestBuffer);
+        if (spillRequestBuffer) spillPool->releaseRequest(spillRequestBuffer);
+        if (spillResponseBuffer) spillPool->releaseResponse(spillResponseBuffer);
         if (responseBuffer) getRedirectPool().release(responseBuffer);
-        if (clientFd >= 0) close(clientFd);
     }
 
-    // Allow moving but not copying
     RequestContext(const RequestContext &) = delete;
 
     RequestContext &operator=(const RequestContext &) = delete;
 
-    RequestContext(RequestContext &&other) noexcept
-        : clientFd(other.clientFd),
-          state(other.state),
-          requestBuffer(other.requestBuffer),
-          decodeBuffer(other.decodeBuffer),
-          encodeBuffer(other.encodeBuffer),
-          responseBuffer(other.responseBuffer),
-          bytesRead(other.bytesRead),
-          responseLen(other.responseLen) {
-        other.clientFd = -1;
-        other.requestBuffer = nullptr;
-        other.decodeBuffer = nullptr;
-        other.encodeBuffer = nullptr;
-        other.responseBuffer = nullptr;
-    }
-
-    RequestContext &operator=(RequestContext &&other) noexcept {
-        if (this != &other) {
-            if (requestBuffer) getRequestPool().release(requestBuffer);
-            if (decodeBuffer) getRequestPool().release(decodeBuffer);
-            if (encodeBuffer) getEncodePool().release(encodeBuffer);
-            if (responseBuffer) getRedirectPool().release(responseBuffer);
-            if (clientFd >= 0) close(clientFd);
-
-            clientFd = other.clientFd;
-            state = other.state;
-            requestBuffer = other.requestBuffer;
-            decodeBuffer = other.decodeBuffer;
-            encodeBuffer = other.encodeBuffer;
-            responseBuffer = other.responseBuffer;
-            bytesRead = other.bytesRead;
-            responseLen = other.responseLen;
-
-            // Reset other
-            other.clientFd = -1;
-            other.requestBuffer = nullptr;
-            other.decodeBuffer = nullptr;
-            other.encodeBuffer = nullptr;
-            other.responseBuffer = nullptr;
-        }
-        return *this;
+    void reset(const int fd, const bool fixed) {
+        clientFd = fd;
+        fixedFile = fixed;
+        state = ConnectionState::READ;
+        bytesRead = 0;
+        headerScan = 0;
+        responseLen = 0;
+        bytesSent = 0;
+        keepAlive = true;
+    }
+
+    [[nodiscard]] size_t responseCapacity() const {
+        return response == responseBuffer ? RESPONSE_BUFFER_SIZE : spillPool->responseCapacity();
+    }
+
+    void acquireResponseBuffer() {
+        if (!responseBuffer) responseBuffer = getRedirectPool().acquire();
+        response = responseBuffer;
+    }
+
+    // Hands the response stage back once everything in it has been sent
+    void releaseResponse() {
+        if (responseLen > 0) return;
+
+        if (responseBuffer) {
+            getRedirectPool().release(responseBuffer);
+            responseBuffer = nullptr;
+        }
+        if (spillResponseBuffer) {
+            spillPool->releaseResponse(spillResponseBuffer);
+            spillResponseBuffer = nullptr;
+        }
+        response = nullptr;
+    }
+
+    // Switches the response stage to a spill block. Returns false when the worker has none left.
+    bool acquireSpillResponse() {
+        if (!spillResponseBuffer && !(spillResponseBuffer = spillPool->acquireResponse())) return false;
+        response = spillResponseBuffer;
+        return true;
+    }
+
+    // Moves the carried partial request into a spill block once it no longer fits the regular request buffer.
+    // Returns false, leaving the request where it was, when the worker has none left.
+    bool spillRequest() {
+        if (requestBuffer && requestBuffer == spillRequestBuffer) return true;
+
+        if (!(spillRequestBuffer = spillPool->acquireRequest())) return false;
+        if (requestBuffer) {
+            memcpy(spillRequestBuffer, requestBuffer, bytesRead);
+            getRequestPool().release(requestBuffer);
+        }
+        requestBuffer = spillRequestBuffer;
+        return true;
+    }
+
+    void releaseRequestBuffer() {
+        if (requestBuffer && requestBuffer != spillRequestBuffer) {
+            getRequestPool().release(requestBuffer);
+        }
+        if (spillRequestBuffer) {
+            spillPool->releaseRequest(spillRequestBuffer);
+            spillRequestBuffer = nullptr;
+        }
+        requestBuffer = nullptr;
+        bytesRead = 0;
+        headerScan = 0;
+    }
+};
+
+// Contexts addressed by slot index. The deque never moves existing slots, so pointers stay valid as it grows, and
+// closed slots are recycled LIFO through the free list so reuse stays cache-hot.
+class ContextSlab {
+public:
+    explicit ContextSlab(SpillPool &spillPool) : m_spillPool(spillPool) {
     }
+
+    RequestContext *acquire(const int fd, const bool fixed) {
+        uint32_t slot;
+        if (!m_freeList.empty()) {
+            slot = m_freeList.back();
+            m_freeList.pop_back();
+        } else {
+            slot = static_cast<uint32_t>(m_slots.size());
+            m_slots.emplace_back(slot, m_spillPool);
+        }
+
+        RequestContext *ctx = &m_slots[slot];
+        ctx->reset(fd, fixed);
+        return ctx;
+    }
+
+    void release(RequestContext *ctx) {
+        ctx->responseLen = 0;
+        ctx->releaseRequestBuffer();
+        ctx->releaseResponse();
+        ctx->clientFd = -1;
+        ctx->state = ConnectionState::CLOSE;
+        m_freeList.push_back(ctx->slot);
+    }
+
+    RequestContext *operator[](const uint32_t slot) { return &m_slots[slot]; }
+
+    [[nodiscard]] uint32_t size() const { return static_cast<uint32_t>(m_slots.size()); }
+
+private:
+    SpillPool &m_spillPool;
+    std::deque<RequestContext> m_slots;
+    std::vector<uint32_t> m_freeList;
 };
 
-void processRequest(RequestContext *ctx) {
-    const char *requestStart = ctx->requestBuffer;
-    const char *requestEnd = ctx->requestBuffer + ctx->bytesRead;
+// Makes room for size more bytes of response. A connection with nothing queued yet takes a regular response buffer,
+// or a spill block when that is too small and the worker has one left; otherwise what is queued has to be sent first.
+bool reserveResponse(RequestContext *ctx, const size_t size) {
+    if (ctx->response && ctx->responseLen + size <= ctx->responseCapacity()) return true;
+    if (ctx->responseLen > 0) return false;
 
-    const std::string_view requestStr(requestStart, ctx->bytesRead);
+    if (size <= RESPONSE_BUFFER_SIZE) {
+        ctx->acquireResponseBuffer();
+        return true;
+    }
+    return size <= ctx->spillPool->responseCapacity() && ctx->acquireSpillResponse();
+}
+
+bool appendHttpResponse(RequestContext *ctx, const HttpStatus status, const std::string_view contentType,
+                        const std::string_view body, const bool keepAlive) {
+    if (!reserveResponse(ctx, maxHttpResponseSize(contentType, body))) return false;
+
+    ctx->responseLen += createHttpResponse(status, contentType, body, ctx->response + ctx->responseLen,
+                                           keepAlive).size();
+    return true;
+}
+
+// Appends the response for one complete request to the connection's response. Returns false, leaving the request
+// unanswered, when it does not fit behind the responses already queued.
+bool processRequest(RequestContext *ctx, const HttpRequest &request, const bool keepAlive) {
+    if (request.path == "/opensearch.xml") {
+        // Serve OpenSearch XML
+        return appendHttpResponse(ctx, HttpStatus::OK, CONTENT_TYPE_XML, OPENSEARCH_XML, keepAlive);
+    }
+    if (request.path == "/" && !request.query.starts_with(QUERY_PARAM.substr(1))) {
+        // Serve home page with OpenSearch link
+        return appendHttpResponse(ctx, HttpStatus::OK, CONTENT_TYPE_HTML, HOME_PAGE_HTML, keepAlive);
+    }
+
+    // Anything else is processed as a potential search query, rendered straight into the response
+    const size_t responseSize = maxSearchResponseSize(request.query);
+    if (!reserveResponse(ctx, responseSize)) {
+        if (ctx->responseLen > 0) return false;
+        if (responseSize <= ctx->spillPool->responseCapacity()) {
+            // Every spill block of this worker is answering some other oversized request
+            return appendHttpResponse(ctx, HttpStatus::SERVICE_UNAVAILABLE, CONTENT_TYPE_HTML, "", keepAlive);
+        }
+        // Not even a spill block holds it, which takes a bang template far longer than any real one
+        return appendHttpResponse(ctx, HttpStatus::URI_TOO_LONG, CONTENT_TYPE_HTML, "", keepAlive);
+    }
+
+    ctx->responseLen += renderSearchResponse(request.query, ctx->response + ctx->responseLen, keepAlive);
+    return true;
+}
+
+// Answers every complete request in data (pipelining) into a single response. Returns how many bytes were
+// consumed; the rest is either an incomplete request or did not fit in this response.
+size_t processRequests(RequestContext *ctx, const char *data, const size_t length) {
+    size_t consumed = 0;
+    HttpRequest request;
+
+    while (ctx->keepAlive && consumed < length) {
+        const size_t requestLen = parseHttpRequest({data + consumed, length - consumed}, request);
+        if (requestLen == std::string_view::npos) break;
+
+        const bool keepAlive = isKeepAlive(request);
+        if (!processRequest(ctx, request, keepAlive)) {
+            break; // Answer the rest once this batch has been sent
+        }
+        ctx->keepAlive = keepAlive;
+        consumed += requestLen;
+    }
 
-    if (const std::string_view path = extractPath(requestStr); path == "/") {
-        // Home page with OpenSearch link
-        if (requestStr.find("?q=") != std::string_view::npos) {
-            const std::string_view url(requestStart, requestEnd - requestStart);
-            auto [searchUrl, encodedQuery] = processQuery(url, ctx->decodeBuffer, ctx->encodeBuffer);
-            ctx->responseLen = createRedirectResponse(searchUrl, encodedQuery, ctx->responseBuffer).size();
+    return consumed;
+}
+
+// Keeps unprocessed bytes on the connection, acquiring its request buffer only now that it is needed and moving to
+// a spill block once the request outgrows it. Reads are capped so the total never exceeds maxRequestSize. Whatever
+// follows a request that closes the connection is never answered, so it is dropped rather than kept.
+void stashPartialRequest(RequestContext *ctx, const char *data, const size_t length) {
+    if (length == 0 || !ctx->keepAlive) return;
+
+    if (ctx->bytesRead + length >= REQUEST_BUFFER_SIZE) {
+        if (!ctx->spillRequest()) {
+            // Every spill block of this worker carries some other oversized request: refuse this one and close
+            ctx->releaseRequestBuffer();
+            ctx->keepAlive = false;
+            appendHttpResponse(ctx, HttpStatus::SERVICE_UNAVAILABLE, CONTENT_TYPE_HTML, "", false);
             return;
         }
-        // Serve home page
-        ctx->responseLen = createHttpResponse(HttpStatus::OK, CONTENT_TYPE_HTML, HOME_PAGE_HTML, ctx->responseBuffer).size();
-    } else if (path == "/opensearch.xml") {
-        // Serve OpenSearch XML
-        ctx->responseLen = createHttpResponse(HttpStatus::OK, CONTENT_TYPE_XML, OPENSEARCH_XML, ctx->responseBuffer).size();
-    } else {
-        // For any other path, process as potential search query
-        const std::string_view url(requestStart, requestEnd - requestStart);
-        auto [searchUrl, encodedQuery] = processQuery(url, ctx->decodeBuffer, ctx->encodeBuffer);
-        ctx->responseLen = createRedirectResponse(searchUrl, encodedQuery, ctx->responseBuffer).size();
+    } else if (!ctx->requestBuffer) {
+        ctx->requestBuffer = getRequestPool().acquire();
     }
+    memcpy(ctx->requestBuffer + ctx->bytesRead, data, length);
+    ctx->bytesRead += length;
+    ctx->requestBuffer[ctx->bytesRead] = '\0';
 }
 
-int setupServerSocket() {
+// Processes what is carried in the connection's request buffer and gives the buffer back once it is drained, or once
+// the connection is closing. A request still missing the end of its headers is not parsed again: only the bytes that
+// arrived since the last look are searched for it. Returns true if there is a response to send.
+bool processBufferedRequests(RequestContext *ctx) {
+    if (ctx->bytesRead > 0) {
+        const std::string_view buffered(ctx->requestBuffer, ctx->bytesRead);
+        if (findHeadersEnd(buffered, ctx->headerScan) == std::string_view::npos) {
+            ctx->headerScan = ctx->bytesRead;
+        } else if (const size_t consumed = processRequests(ctx, ctx->requestBuffer, ctx->bytesRead); consumed > 0) {
+            ctx->bytesRead -= consumed;
+            ctx->headerScan = 0;
+            memmove(ctx->requestBuffer, ctx->requestBuffer + consumed, ctx->bytesRead);
+            ctx->requestBuffer[ctx->bytesRead] = '\0';
+        }
+    }
+
+    if (ctx->bytesRead == 0 || !ctx->keepAlive) {
+        ctx->releaseRequestBuffer();
+    }
+
+    return ctx->responseLen > 0;
+}
+
+// For a connection with nothing left to send: read more of the request, unless it has already reached
+// maxRequestSize without the end of its headers, in which case it is refused and the connection closed
+void awaitRequestData(RequestContext *ctx) {
+    if (ctx->bytesRead < ctx->spillPool->maxRequestSize()) {
+        ctx->state = ConnectionState::READ;
+        return;
+    }
+
+    ctx->releaseRequestBuffer();
+    ctx->keepAlive = false;
+    appendHttpResponse(ctx, HttpStatus::REQUEST_HEADER_FIELDS_TOO_LARGE, CONTENT_TYPE_HTML, "", false);
+    ctx->state = ConnectionState::WRITE;
+}
+
+// Kernel-provided receive buffers shared by all connections of a worker. A recv only claims one when bytes
+// actually arrive, and it goes straight back to the ring once the requests in it have been processed. Every request
+// lands here first, so in huge page mode the buffers are carved from a huge page arena of the worker's own.
+struct RecvBufferRing {
+    io_uring_buf_ring *ring = nullptr;
+    char *buffers = nullptr;
+    int mask = 0;
+
+    bool init(io_uring *uring, const bool hugePages, const bool lockPages) {
+        int ret = 0;
+        ring = io_uring_setup_buf_ring(uring, BUFFER_RING_ENTRIES, BUFFER_GROUP_ID, 0, &ret);
+        if (!ring) {
+            std::cerr << "Failed to register buffer ring: " << strerror(-ret) << "\n";
+            return false;
+        }
+
+        constexpr size_t size = BUFFER_RING_ENTRIES * REQUEST_BUFFER_SIZE;
+        if (hugePages) {
+            const HugePageRegion arena = mapHugePages((size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE,
+                                                      lockPages);
+            buffers = arena.base;
+            if (!buffers) {
+                std::cerr << "Receive buffer arena could not be mapped, using heap buffers\n";
+            } else if (lockPages && !arena.locked) {
+                std::cerr << "Receive buffer arena could not be locked (see ulimit -l)\n";
+            }
+        }
+        if (!buffers) {
+            buffers = static_cast<char *>(alignedAlloc(size, 4096));
+        }
+        if (!buffers) {
+            std::cerr << "Failed to allocate receive buffers\n";
+            return false;
+        }
+
+        mask = io_uring_buf_ring_mask(BUFFER_RING_ENTRIES);
+        for (unsigned i = 0; i < BUFFER_RING_ENTRIES; ++i) {
+            io_uring_buf_ring_add(ring, buffer(i), REQUEST_BUFFER_SIZE, i, mask, static_cast<int>(i));
+        }
+        io_uring_buf_ring_advance(ring, BUFFER_RING_ENTRIES);
+        return true;
+    }
+
+    [[nodiscard]] char *buffer(const unsigned bufferId) const {
+        return buffers + static_cast<size_t>(bufferId) * REQUEST_BUFFER_SIZE;
+    }
+
+    void recycle(const unsigned bufferId) const {
+        io_uring_buf_ring_add(ring, buffer(bufferId), REQUEST_BUFFER_SIZE, bufferId, mask, 0);
+        io_uring_buf_ring_advance(ring, 1);
+    }
+};
+
+int setupServerSocket(const bool reusePort) {
     const int serverSocket = socket(AF_INET, SOCK_STREAM, 0);
     if (serverSocket < 0) {
         std::cerr << "Failed to create socket\n";
@@ -157,6 +516,13 @@ int setupServerSocket() {
         return -1;
     }
 
+    // Each worker binds its own listener to the same port; the kernel load-balances new connections across them
+    if (reusePort && setsockopt(serverSocket, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) < 0) {
+        std::cerr << "Failed to set socket options (SO_REUSEPORT)\n";
+        close(serverSocket);
+        return -1;
+    }
+
     if (setsockopt(serverSocket, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt)) < 0) {
         std::cerr << "Failed to set socket options (TCP_NODELAY)\n";
         close(serverSocket);
@@ -189,134 +555,689 @@ int setupServerSocket() {
     return serverSocket;
 }
 
-void addAcceptRequest(io_uring *ring, const int serverFd, sockaddr_in *clientAddr, socklen_t *clientAddrLen,
-                      RequestContext *ctx) {
+// Response pool blocks registered with a worker's ring, so sends can skip pinning the user pages each time. A
+// response arena goes in whole as buffer 0; only heap blocks outside it are registered one by one.
+struct RegisteredBuffers {
+    absl::flat_hash_map<const char *, int> indices;
+    HugePageRegion arena;
+
+    bool init(io_uring *ring) {
+        const std::vector<char *> blocks = getRedirectPool().blocks();
+        arena = getRedirectPool().arena();
+
+        std::vector<iovec> iovecs;
+        iovecs.reserve(blocks.size() + 1);
+        if (arena.base) {
+            iovecs.push_back({arena.base, arena.size});
+        }
+        for (char *block: blocks) {
+            if (arena.contains(block)) continue;
+            indices[block] = static_cast<int>(iovecs.size());
+            iovecs.push_back({block, getRedirectPool().bufferSize()});
+        }
+
+        if (const int ret = io_uring_register_buffers(ring, iovecs.data(), iovecs.size()); ret < 0) {
+            std::cerr << "Failed to register response buffers: " << strerror(-ret) << "\n";
+            return false;
+        }
+        return true;
+    }
+
+    [[nodiscard]] int find(const char *buffer) const {
+        if (arena.contains(buffer)) return 0;
+        const auto it = indices.find(buffer);
+        return it != indices.end() ? it->second : -1;
+    }
+};
+
+// Returns a free SQE, flushing the queue to the kernel once if it is full. nullptr means the SQ is still full and
+// the caller has to defer its request until the current batch of completions has been handled.
+io_uring_sqe *getSqe(io_uring *ring) {
     io_uring_sqe *sqe = io_uring_get_sqe(ring);
-    io_uring_prep_accept(sqe, serverFd, reinterpret_cast<sockaddr *>(clientAddr), clientAddrLen, 0);
-    io_uring_sqe_set_data(sqe, ctx);
+    if (!sqe) {
+        io_uring_submit(ring);
+        sqe = io_uring_get_sqe(ring);
+    }
+    return sqe;
 }
 
-void addReadRequest(io_uring *ring, RequestContext *ctx) {
-    io_uring_sqe *sqe = io_uring_get_sqe(ring);
-    io_uring_prep_recv(sqe, ctx->clientFd, ctx->requestBuffer, REQUEST_BUFFER_SIZE - 1, 0);
-    io_uring_sqe_set_data(sqe, ctx);
+// One multishot accept stays armed on the listener and posts a completion per accepted connection. The peer
+// address is never used, so none is requested. In registered I/O mode the kernel installs each connection
+// straight into the fixed file table and the completion carries the slot instead of an fd.
+bool addAcceptRequest(io_uring *ring, const int serverFd, const bool direct) {
+    io_uring_sqe *sqe = getSqe(ring);
+    if (!sqe) return false;
+
+    if (direct) {
+        io_uring_prep_multishot_accept_direct(sqe, serverFd, nullptr, nullptr, 0);
+    } else {
+        io_uring_prep_multishot_accept(sqe, serverFd, nullptr, nullptr, 0);
+    }
+    io_uring_sqe_set_data64(sqe, makeUserData(0, Operation::ACCEPT));
+    return true;
 }
 
-void addWriteRequest(io_uring *ring, RequestContext *ctx) {
-    io_uring_sqe *sqe = io_uring_get_sqe(ring);
-    io_uring_prep_send(sqe, ctx->clientFd, ctx->responseBuffer, ctx->responseLen, 0);
-    io_uring_sqe_set_data(sqe, ctx);
+// The kernel picks the buffer from the ring; the length caps the read so a carried partial request never grows
+// past the request size limit
+bool addReadRequest(io_uring *ring, RequestContext *ctx) {
+    io_uring_sqe *sqe = getSqe(ring);
+    if (!sqe) return false;
+
+    const size_t length = std::min(REQUEST_BUFFER_SIZE, ctx->spillPool->maxRequestSize() - ctx->bytesRead);
+    io_uring_prep_recv(sqe, ctx->clientFd, nullptr, length, 0);
+    io_uring_sqe_set_flags(sqe, IOSQE_BUFFER_SELECT | (ctx->fixedFile ? IOSQE_FIXED_FILE : 0));
+    sqe->buf_group = BUFFER_GROUP_ID;
+    io_uring_sqe_set_data64(sqe, makeUserData(ctx->slot, Operation::READ));
+    return true;
 }
 
-void addCloseRequest(io_uring *ring, RequestContext *ctx) {
-    io_uring_sqe *sqe = io_uring_get_sqe(ring);
-    io_uring_prep_nop(sqe);
-    io_uring_sqe_set_data(sqe, ctx);
+void prepWrite(io_uring_sqe *sqe, const RequestContext *ctx) {
+    const char *data = ctx->response + ctx->bytesSent;
+    const size_t length = ctx->responseLen - ctx->bytesSent;
+
+    if (ctx->responseBufferIndex >= 0) {
+        // Sockets ignore the offset; write_fixed is the send variant that takes a registered buffer
+        io_uring_prep_write_fixed(sqe, ctx->clientFd, data, length, 0, ctx->responseBufferIndex);
+    } else {
+        io_uring_prep_send(sqe, ctx->clientFd, data, length, MSG_WAITALL);
+    }
+    if (ctx->fixedFile) {
+        io_uring_sqe_set_flags(sqe, IOSQE_FIXED_FILE);
+    }
+    io_uring_sqe_set_data64(sqe, makeUserData(ctx->slot, Operation::WRITE));
 }
 
-int main() {
-    std::cout << "Loading bang data from DuckDuckGo API..." << std::endl;
-    if (!loadBangDataFromUrl("https://duckduckgo.com/bang.js")) {
-        std::cerr << "Failed to load bang data from API\n";
-        return 1;
+void prepClose(io_uring_sqe *sqe, const RequestContext *ctx) {
+    if (ctx->fixedFile) {
+        io_uring_prep_close_direct(sqe, ctx->clientFd);
+    } else {
+        io_uring_prep_close(sqe, ctx->clientFd);
     }
-    std::cout << "Successfully loaded " << ALL_BANGS.size() << " bang URLs from API\n";
+    io_uring_sqe_set_data64(sqe, makeUserData(ctx->slot, Operation::CLOSE));
+}
 
-    const std::string customBangsPath = getCustomBangsFilePath();
-    loadBangDataFromFile(customBangsPath);
-    
-    std::cout << "Total loaded bangs: " << ALL_BANGS.size() << "\n";
+bool addWriteRequest(io_uring *ring, RequestContext *ctx) {
+    io_uring_sqe *sqe = getSqe(ring);
+    if (!sqe) return false;
+
+    prepWrite(sqe, ctx);
+    return true;
+}
+
+// Sends the final response and closes the socket in one submission. The hard link runs the close even if the send
+// fails, and a successful send posts no completion, so the close completion alone retires the slot. Only for plain
+// sends: MSG_WAITALL keeps those from coming up short except on errors, while a short write_fixed would break the
+// link and close the socket on a truncated response.
+bool addWriteAndCloseRequest(io_uring *ring, RequestContext *ctx) {
+    if (io_uring_sq_space_left(ring) < 2) {
+        io_uring_submit(ring);
+        if (io_uring_sq_space_left(ring) < 2) return false;
+    }
+
+    io_uring_sqe *sendSqe = io_uring_get_sqe(ring);
+    prepWrite(sendSqe, ctx);
+    sendSqe->flags |= IOSQE_IO_HARDLINK | IOSQE_CQE_SKIP_SUCCESS;
+
+    prepClose(io_uring_get_sqe(ring), ctx);
+    return true;
+}
+
+bool addCloseRequest(io_uring *ring, RequestContext *ctx) {
+    io_uring_sqe *sqe = getSqe(ring);
+    if (!sqe) return false;
+
+    prepClose(sqe, ctx);
+    return true;
+}
+
+bool addTickRequest(io_uring *ring, __kernel_timespec *interval) {
+    io_uring_sqe *sqe = getSqe(ring);
+    if (!sqe) return false;
 
-    const int serverFd = setupServerSocket();
-    if (serverFd < 0) {
-        return serverFd;
+    io_uring_prep_timeout(sqe, interval, 0, 0);
+    io_uring_sqe_set_data64(sqe, makeUserData(0, Operation::TICK));
+    return true;
+}
+
+// Cancels the connection's pending operation of type op. Its completion then fails like any other and closes the
+// connection; only a failure to cancel (there was nothing to) posts a completion of its own.
+bool addCancelRequest(io_uring *ring, const uint32_t slot, const Operation op) {
+    io_uring_sqe *sqe = getSqe(ring);
+    if (!sqe) return false;
+
+    io_uring_prep_cancel64(sqe, makeUserData(slot, op), 0);
+    io_uring_sqe_set_flags(sqe, IOSQE_CQE_SKIP_SUCCESS);
+    io_uring_sqe_set_data64(sqe, makeUserData(slot, Operation::CANCEL));
+    return true;
+}
+
+// Per-thread server state
+struct Worker {
+    explicit Worker(const int fd, const ServerOptions &opts)
+        : serverFd(fd), options(opts), spillPool(opts.maxRequestSize), contexts(spillPool) {
     }
 
     io_uring ring{};
+    int serverFd;
+    const ServerOptions &options;
+    RecvBufferRing recvBuffers;
+    RegisteredBuffers registeredBuffers;
+    SpillPool spillPool;
+    ContextSlab contexts;
+
+    // Requests that found the SQ full, resubmitted once the current batch of completions has been handled
+    std::vector<RequestContext *> deferred;
+    bool acceptDeferred = false;
+
+    // The idle sweep's clock, in seconds since the worker started
+    __kernel_timespec tickInterval{.tv_sec = 1, .tv_nsec = 0};
+    uint32_t tick = 0;
+    bool tickDeferred = false;
+};
+
+// Queues the operation for the connection's current state, or defers it while the SQ is full
+void queueRequest(Worker &worker, RequestContext *ctx) {
+    bool queued = true;
+    switch (ctx->state) {
+        case ConnectionState::READ:
+            queued = addReadRequest(&worker.ring, ctx);
+            break;
+        case ConnectionState::WRITE:
+            if (worker.options.registeredIo) {
+                // The response buffer changes between responses; spill blocks and later growth are not registered
+                ctx->responseBufferIndex = worker.registeredBuffers.find(ctx->response);
+            }
+            if (ctx->keepAlive || ctx->responseBufferIndex >= 0) {
+                // Registered sends are closed once their completion shows everything went out
+                queued = addWriteRequest(&worker.ring, ctx);
+            } else if ((queued = addWriteAndCloseRequest(&worker.ring, ctx))) {
+                ctx->state = ConnectionState::CLOSE;
+            }
+            break;
+        case ConnectionState::CLOSE:
+            queued = addCloseRequest(&worker.ring, ctx);
+            break;
+        case ConnectionState::PROCESS:
+            break;
+    }
+
+    if (!queued) {
+        worker.deferred.push_back(ctx);
+    }
+}
+
+void queueAccept(Worker &worker) {
+    worker.acceptDeferred = !addAcceptRequest(&worker.ring, worker.serverFd, worker.options.registeredIo);
+}
+
+void queueTick(Worker &worker) {
+    worker.tickDeferred = !addTickRequest(&worker.ring, &worker.tickInterval);
+}
+
+void retryDeferred(Worker &worker) {
+    if (worker.acceptDeferred) {
+        queueAccept(worker);
+    }
+    if (worker.tickDeferred) {
+        queueTick(worker);
+    }
+
+    if (worker.deferred.empty()) return;
+
+    std::vector<RequestContext *> pending;
+    pending.swap(worker.deferred);
+    for (RequestContext *ctx: pending) {
+        queueRequest(worker, ctx);
+    }
+}
+
+void handleAccept(Worker &worker, const int res, const unsigned flags) {
+    if (res >= 0) {
+        // A context is only taken from the slab once a connection has actually arrived
+        RequestContext *ctx = worker.contexts.acquire(res, worker.options.registeredIo);
+        ctx->lastActive = worker.tick;
+        queueRequest(worker, ctx);
+    }
+
+    // The kernel terminates a multishot accept on errors (and on overflow); re-arm it
+    if (!(flags & IORING_CQE_F_MORE)) {
+        queueAccept(worker);
+    }
+}
+
+// Runs once a second. Connections that have been waiting on their peer for idleTimeout seconds get the recv or send
+// they wait on cancelled, which closes them, so dead peers and slow clients cannot hold a slot, a socket and a
+// carried request forever. Receiving part of a request does not count as activity, only answering one does.
+void sweepIdleConnections(Worker &worker) {
+    ++worker.tick;
+    const auto timeout = static_cast<uint32_t>(worker.options.idleTimeout);
+    for (uint32_t slot = 0; slot < worker.contexts.size(); ++slot) {
+        const RequestContext *ctx = worker.contexts[slot];
+        if (ctx->clientFd < 0 || worker.tick - ctx->lastActive < timeout) continue;
+
+        // A closing connection may still be sending its final response ahead of the linked close
+        const Operation op = ctx->state == ConnectionState::READ ? Operation::READ : Operation::WRITE;
+        if (!addCancelRequest(&worker.ring, slot, op)) break; // The SQ is full; the next sweep gets the rest
+    }
+    queueTick(worker);
+}
+
+void handleCompletion(Worker &worker, const io_uring_cqe *cqe) {
+    const int res = cqe->res;
+    const unsigned flags = cqe->flags;
+
+    const Operation op = userDataOperation(cqe->user_data);
+    if (op == Operation::ACCEPT) {
+        handleAccept(worker, res, flags);
+        return;
+    }
+    if (op == Operation::TICK) {
+        sweepIdleConnections(worker);
+        return;
+    }
+    if (op == Operation::CANCEL) {
+        return; // The operation had already completed
+    }
+
+    RequestContext *ctx = worker.contexts[userDataSlot(cqe->user_data)];
+
+    if (op == Operation::READ) {
+        if (res == -ENOBUFS) {
+            // Every ring buffer is in use for this batch; they are recycled before the next one, so just retry
+            queueRequest(worker, ctx);
+        } else if (res <= 0) {
+            ctx->state = ConnectionState::CLOSE;
+            queueRequest(worker, ctx);
+        } else {
+            const unsigned bufferId = flags >> IORING_CQE_BUFFER_SHIFT;
+            const char *data = worker.recvBuffers.buffer(bufferId);
+            ctx->state = ConnectionState::PROCESS;
+
+            if (ctx->bytesRead == 0) {
+                // Common case: parse straight out of the ring buffer and only copy a leftover partial request
+                const size_t consumed = processRequests(ctx, data, res);
+                stashPartialRequest(ctx, data + consumed, res - consumed);
+            } else {
+                stashPartialRequest(ctx, data, res);
+                processBufferedRequests(ctx);
+            }
+            worker.recvBuffers.recycle(bufferId);
+
+            // Write the response, or keep reading after what we already have if the request is still incomplete
+            if (ctx->responseLen > 0) {
+                ctx->state = ConnectionState::WRITE;
+                ctx->lastActive = worker.tick;
+            } else {
+                awaitRequestData(ctx);
+            }
+            queueRequest(worker, ctx);
+        }
+    } else if (op == Operation::WRITE) {
+        if (ctx->state == ConnectionState::CLOSE) {
+            // Failed send of a final response; the hard-linked close is still on its way
+            return;
+        }
+
+        ctx->lastActive = worker.tick; // Whatever it sent, the peer is taking the response (or it is closed below)
+        if (res < 0) {
+            ctx->state = ConnectionState::CLOSE;
+        } else if (ctx->bytesSent += res; ctx->bytesSent < ctx->responseLen) {
+            // Short send, push out the remainder
+        } else {
+            ctx->responseLen = 0;
+            ctx->bytesSent = 0;
+
+            if (!ctx->keepAlive) {
+                ctx->state = ConnectionState::CLOSE;
+            } else if (!processBufferedRequests(ctx)) {
+                // Otherwise there were pipelined requests that did not fit in the previous response
+                ctx->releaseResponse();
+                awaitRequestData(ctx);
+            }
+        }
+        queueRequest(worker, ctx);
+    } else if (op == Operation::CLOSE) {
+        worker.contexts.release(ctx);
+    }
+}
+
+void pinToCore(const int workerId) {
+    const unsigned cores = std::thread::hardware_concurrency();
+    if (cores == 0) return;
+
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    CPU_SET(workerId % cores, &cpuset);
+    pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset);
+}
+
+// Each worker owns its ring, its listener and its contexts; the only shared state is the published bang table
+int runWorker(const int workerId, const int serverFd, const ServerOptions &options) {
+    if (options.workers > 1) {
+        pinToCore(workerId);
+    }
+
+    registerBangTableReader();
+    Worker worker(serverFd, options);
     io_uring_params params{};
-    if (io_uring_queue_init_params(QUEUE_DEPTH, &ring, &params) < 0) {
-        std::cerr << "Failed to initialize io_uring\n";
+    if (io_uring_queue_init_params(QUEUE_DEPTH, &worker.ring, &params) < 0) {
+        std::cerr << "Failed to initialize io_uring for worker " << workerId << "\n";
         close(serverFd);
         return 1;
     }
 
-    std::cout << "BangServer starting on http://127.0.0.1:" << PORT << "\n";
-    std::cout << "Ready\n";
-
-    sockaddr_in clientAddr{};
-    socklen_t clientAddrLen = sizeof(clientAddr);
-
-    std::vector<std::unique_ptr<RequestContext> > contexts;
+    if (!worker.recvBuffers.init(&worker.ring, options.hugePages, options.lockPages)) {
+        io_uring_queue_exit(&worker.ring);
+        close(serverFd);
+        return 1;
+    }
 
-    auto initialCtx = std::make_unique<RequestContext>();
-    addAcceptRequest(&ring, serverFd, &clientAddr, &clientAddrLen, initialCtx.get());
-    contexts.push_back(std::move(initialCtx));
+    if (options.registeredIo) {
+        if (const int ret = io_uring_register_files_sparse(&worker.ring, FIXED_FILE_TABLE_SIZE); ret < 0) {
+            std::cerr << "Failed to register fixed file table: " << strerror(-ret) << "\n";
+            io_uring_queue_exit(&worker.ring);
+            close(serverFd);
+            return 1;
+        }
+        if (!worker.registeredBuffers.init(&worker.ring)) {
+            io_uring_queue_exit(&worker.ring);
+            close(serverFd);
+            return 1;
+        }
+    }
 
-    io_uring_submit(&ring);
+    queueAccept(worker);
+    if (options.idleTimeout > 0) {
+        queueTick(worker);
+    }
 
     // ReSharper disable once CppDFAEndlessLoop
     while (true) {
-        io_uring_cqe *cqe;
-        if (const int ret = io_uring_wait_cqe(&ring, &cqe); ret < 0) {
+        // A single syscall per batch: submit everything queued while handling the previous batch and wait for more.
+        // Nothing from the bang table is held across it, so a reload never has to wait for an idle worker.
+        bangTableOffline();
+        if (const int ret = io_uring_submit_and_wait(&worker.ring, 1); ret < 0 && ret != -EINTR) {
             std::cerr << "Error waiting for completion: " << strerror(-ret) << std::endl;
-            continue;
         }
+        bangTableOnline();
 
-        auto *ctx = static_cast<RequestContext *>(io_uring_cqe_get_data(cqe));
-        if (!ctx) {
-            io_uring_cqe_seen(&ring, cqe);
-            continue;
+        unsigned head;
+        unsigned count = 0;
+        io_uring_cqe *cqe;
+        io_uring_for_each_cqe(&worker.ring, head, cqe) {
+            handleCompletion(worker, cqe);
+            ++count;
         }
+        io_uring_cq_advance(&worker.ring, count);
 
-        const int res = cqe->res;
-        io_uring_cqe_seen(&ring, cqe);
+        retryDeferred(worker);
+    }
 
-        if (ctx->state == ConnectionState::ACCEPT) {
-            if (res < 0) {
-                // Accept failed, submit a new accept
-                auto newCtx = std::make_unique<RequestContext>();
-                addAcceptRequest(&ring, serverFd, &clientAddr, &clientAddrLen, newCtx.get());
-                contexts.push_back(std::move(newCtx));
-            } else {
-                // Accept succeeded, prepare for read
-                ctx->clientFd = res;
-                ctx->state = ConnectionState::READ;
-                addReadRequest(&ring, ctx);
-
-                auto newCtx = std::make_unique<RequestContext>();
-                addAcceptRequest(&ring, serverFd, &clientAddr, &clientAddrLen, newCtx.get());
-                contexts.push_back(std::move(newCtx));
+    //io_uring_queue_exit(&worker.ring);
+    //close(serverFd);
+    //return 0;
+}
+
+// Falls back to heap blocks with a warning, the server works either way
+void reserveArena(MemoryPool &pool, const std::string_view name, const size_t count, const bool lockPages) {
+    if (!pool.reserveArena(count, lockPages)) {
+        std::cerr << name << " arena could not be mapped, using heap buffers\n";
+        return;
+    }
+
+    const HugePageRegion &arena = pool.arena();
+    std::cout << name << " arena: " << arena.size / (1024 * 1024) << " MiB on "
+            << (arena.hugeTlb ? "explicit" : "transparent") << " huge pages" << (arena.locked ? ", locked" : "")
+            << "\n";
+    if (lockPages && !arena.locked) {
+        std::cerr << name << " arena could not be locked (see ulimit -l)\n";
+    }
+}
+
+// The only thread that loads bangs once the server runs, so no worker ever waits for a fetch or a rebuild. Reloads the
+// custom bangs on SIGHUP (read from signalFd) and whenever the custom bangs file is written, replaced or removed, and
+// refreshes the upstream bangs every refreshInterval seconds, saving a new snapshot whenever they change. Bangs that
+// came from a snapshot or the binary are refreshed once right away, even if refreshing is off. The directory is
+// watched rather than the file, since editors tend to save by renaming a new file over the old one.
+void watchBangSources(const std::string &path, const int signalFd, const ServerOptions &options,
+                      const bool refreshNow) {
+    const std::filesystem::path file(path);
+    const std::string directory = file.has_parent_path() ? file.parent_path().string() : ".";
+    const std::string name = file.filename().string();
+
+    int inotifyFd = inotify_init1(IN_CLOEXEC);
+    if (inotifyFd >= 0 && inotify_add_watch(inotifyFd, directory.c_str(),
+                                            IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE) < 0) {
+        close(inotifyFd);
+        inotifyFd = -1;
+    }
+    if (inotifyFd < 0) {
+        std::cerr << "Not watching " << path << " for changes: " << strerror(errno) << "\n";
+        if (signalFd < 0 && options.refreshInterval <= 0 && !refreshNow) return;
+    }
+
+    using Clock = std::chrono::steady_clock;
+    const auto interval = std::chrono::seconds(options.refreshInterval);
+    auto nextRefresh = Clock::now() + interval;
+    bool refreshPending = refreshNow;
+
+    // poll skips negative descriptors, so either source may be missing
+    pollfd fds[] = {{signalFd, POLLIN, 0}, {inotifyFd, POLLIN, 0}};
+    alignas(inotify_event) char events[4096];
+    while (true) {
+        int timeout = -1;
+        if (refreshPending) {
+            timeout = 0;
+        } else if (options.refreshInterval > 0) {
+            const auto remaining = std::chrono::ceil<std::chrono::milliseconds>(nextRefresh - Clock::now());
+            timeout = static_cast<int>(std::max<std::chrono::milliseconds::rep>(0, remaining.count()));
+        }
+
+        const int ready = poll(fds, std::size(fds), timeout);
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "Stopped watching for bang reloads: " << strerror(errno) << "\n";
+            return;
+        }
+        if (ready == 0) {
+            if (refreshBangDataFromUrl(options.upstreamUrl, path) && !options.snapshotPath.empty()) {
+                saveBangSnapshot(options.snapshotPath);
             }
-        } else if (ctx->state == ConnectionState::READ) {
-            if (res <= 0) {
-                ctx->state = ConnectionState::CLOSE;
-                addCloseRequest(&ring, ctx);
-            } else {
-                ctx->bytesRead = res;
-                ctx->requestBuffer[ctx->bytesRead] = '\0';
-                ctx->state = ConnectionState::PROCESS;
+            refreshPending = false;
+            nextRefresh = Clock::now() + interval;
+            continue;
+        }
 
-                processRequest(ctx);
+        bool reload = false;
+        if (fds[0].revents & POLLIN) {
+            signalfd_siginfo info{};
+            reload = read(signalFd, &info, sizeof(info)) == sizeof(info);
+        }
+        if (fds[1].revents & POLLIN) {
+            const ssize_t length = read(inotifyFd, events, sizeof(events));
+            for (ssize_t offset = 0; offset < length;) {
+                const auto *event = reinterpret_cast<const inotify_event *>(events + offset);
+                if (event->len > 0 && name == event->name) reload = true;
+                offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+            }
+        }
 
-                ctx->state = ConnectionState::WRITE;
-                addWriteRequest(&ring, ctx);
+        if (reload) {
+            reloadBangDataFromFile(path);
+        }
+    }
+}
+
+void printUsage(std::ostream &out) {
+    out << "Usage: bangserver [options]\n"
+            << "Options:\n"
+            << "  --workers, -w WORKERS Number of worker threads, one io_uring each (default: 1, 0 = all cores)\n"
+            << "  --registered-io, -r   Use direct descriptors and registered response buffers\n"
+            << "  --hugepages           Carve receive, request and response buffers from huge page arenas\n"
+            << "  --mlock               Same as --hugepages, and lock the arenas into RAM\n"
+            << "  --max-request-size, -m BYTES\n"
+            << "                        Largest request accepted, headers included (default: 65536)\n"
+            << "  --idle-timeout SECONDS\n"
+            << "                        Close connections that wait this long for a request to complete or for\n"
+            << "                        a response to be taken (default: 30, 0 = never)\n"
+            << "  --upstream URL        Where to load the bangs from (default: https://duckduckgo.com/bang.js)\n"
+            << "  --refresh-interval SECONDS\n"
+            << "                        How often to check the upstream bangs for changes (default: 21600,\n"
+            << "                        0 = only at startup)\n"
+            << "  --snapshot FILE       Start from the bangs saved in FILE and keep it up to date\n"
+            << "                        (default: bangs.snapshot)\n"
+            << "  --no-snapshot         Neither read nor write a snapshot of the bangs\n"
+            << "  --simd TIER           Force the SIMD kernels to scalar, sse4.2, avx2 or avx512\n"
+            << "                        (default: the widest this CPU supports)\n"
+            << "  --help, -h            Show this help message\n";
+}
+
+// Parses the whole of text as a decimal number, so "abc", "12x" and anything out of range are rejected rather than
+// cut short or wrapped around
+template<typename T>
+std::optional<T> parseNumber(const std::string_view text) {
+    T value{};
+    const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (error != std::errc() || end != text.data() + text.size()) return std::nullopt;
+    return value;
+}
+
+int invalidOption(const std::string_view option, const std::string_view value) {
+    std::cerr << "Invalid value for " << option << ": " << value << "\n";
+    printUsage(std::cerr);
+    return 1;
+}
+
+int main(const int argc, char *argv[]) {
+    ServerOptions options;
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::string arg = argv[i]; (arg == "--workers" || arg == "-w") && i + 1 < argc) {
+            const auto workers = parseNumber<int>(argv[++i]);
+            if (!workers) return invalidOption(arg, argv[i]);
+            options.workers = *workers;
+        } else if (arg == "--registered-io" || arg == "-r") {
+            options.registeredIo = true;
+        } else if (arg == "--hugepages") {
+            options.hugePages = true;
+        } else if (arg == "--mlock") {
+            options.hugePages = true;
+            options.lockPages = true;
+        } else if ((arg == "--max-request-size" || arg == "-m") && i + 1 < argc) {
+            const auto size = parseNumber<size_t>(argv[++i]);
+            if (!size) return invalidOption(arg, argv[i]);
+            options.maxRequestSize = std::max(REQUEST_BUFFER_SIZE, *size);
+        } else if (arg == "--idle-timeout" && i + 1 < argc) {
+            const auto timeout = parseNumber<int>(argv[++i]);
+            if (!timeout) return invalidOption(arg, argv[i]);
+            options.idleTimeout = std::max(0, *timeout);
+        } else if (arg == "--upstream" && i + 1 < argc) {
+            options.upstreamUrl = argv[++i];
+        } else if (arg == "--refresh-interval" && i + 1 < argc) {
+            const auto interval = parseNumber<int>(argv[++i]);
+            if (!interval) return invalidOption(arg, argv[i]);
+            options.refreshInterval = std::max(0, *interval);
+        } else if (arg == "--snapshot" && i + 1 < argc) {
+            options.snapshotPath = argv[++i];
+        } else if (arg == "--no-snapshot") {
+            options.snapshotPath.clear();
+        } else if (arg == "--simd" && i + 1 < argc) {
+            const auto tier = parseSimdTier(argv[++i]);
+            if (!tier) {
+                std::cerr << "Unknown SIMD tier " << argv[i] << " (expected scalar, sse4.2, avx2 or avx512)\n";
+                return 1;
             }
-        } else if (ctx->state == ConnectionState::WRITE) {
-            ctx->state = ConnectionState::CLOSE;
-            addCloseRequest(&ring, ctx);
-        } else if (ctx->state == ConnectionState::CLOSE) {
-            for (auto it = contexts.begin(); it != contexts.end(); ++it) {
-                if (it->get() == ctx) {
-                    contexts.erase(it);
-                    break;
-                }
+            if (!setSimdTier(*tier)) {
+                std::cerr << "This CPU does not support " << argv[i] << ", the widest it has is "
+                        << simdTierName(detectSimdTier()) << "\n";
+                return 1;
             }
+        } else if (arg == "--help" || arg == "-h") {
+            printUsage(std::cout);
+            return 0;
         }
+    }
 
-        io_uring_submit(&ring);
+    if (options.workers <= 0) {
+        options.workers = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
     }
+    const int workers = options.workers;
 
-    //io_uring_queue_exit(&ring);
-    //close(serverFd);
-    //return 0;
+    // A snapshot of the last download, or failing that the bangs built into the binary, get the server going without
+    // waiting for the network; the refresh catches up with upstream in the background
+    const bool fromSnapshot = !options.snapshotPath.empty() && loadBangDataFromSnapshot(options.snapshotPath);
+    const bool stale = fromSnapshot || loadEmbeddedBangData();
+    if (!stale) {
+        std::cout << "Loading bang data from " << options.upstreamUrl << "..." << std::endl;
+        if (!loadBangDataFromUrl(options.upstreamUrl)) {
+            std::cerr << "Failed to load bang data from API\n";
+            return 1;
+        }
+        std::cout << "Successfully loaded " << bangTable().size() << " bang URLs from API\n";
+        if (!options.snapshotPath.empty()) {
+            saveBangSnapshot(options.snapshotPath);
+        }
+    }
+
+    const std::string customBangsPath = getCustomBangsFilePath();
+    loadBangDataFromFile(customBangsPath);
+
+    std::cout << "Total loaded bangs: " << bangTable().size() << "\n";
+    std::cout << "SIMD kernels: " << simdTierName(activeSimdTier()) << "\n";
+
+    // Blocked before any other thread exists, so every thread inherits the mask and SIGHUP only ever reaches the
+    // reloader's signalfd
+    sigset_t reloadSignals;
+    sigemptyset(&reloadSignals);
+    sigaddset(&reloadSignals, SIGHUP);
+    pthread_sigmask(SIG_BLOCK, &reloadSignals, nullptr);
+    const int signalFd = signalfd(-1, &reloadSignals, SFD_CLOEXEC);
+    if (signalFd < 0) {
+        std::cerr << "Failed to create signalfd, SIGHUP will not reload bangs: " << strerror(errno) << "\n";
+    }
+    std::thread(watchBangSources, customBangsPath, signalFd, options, stale).detach();
+
+    // Allocate the response buffers every worker registers before any of them starts
+    if (options.hugePages) {
+        reserveArena(getRedirectPool(), "Response", REGISTERED_RESPONSE_BUFFERS, options.lockPages);
+        reserveArena(getRequestPool(), "Request", ARENA_REQUEST_BUFFERS, options.lockPages);
+    }
+    if (options.registeredIo) {
+        getRedirectPool().reserve(REGISTERED_RESPONSE_BUFFERS);
+    }
+
+    // Bind every listener before starting any worker so a port conflict fails the whole server up front
+    const bool sharded = workers > 1;
+    std::vector<int> serverFds;
+    serverFds.reserve(workers);
+    for (int i = 0; i < workers; ++i) {
+        const int serverFd = setupServerSocket(sharded);
+        if (serverFd < 0) {
+            for (const int fd: serverFds) {
+                close(fd);
+            }
+            return serverFd;
+        }
+        serverFds.push_back(serverFd);
+    }
+
+    std::cout << "BangServer starting on http://127.0.0.1:" << PORT << " with " << workers << " worker"
+            << (sharded ? "s" : "") << "\n";
+    std::cout << "Ready\n";
+
+    if (!sharded) {
+        return runWorker(0, serverFds[0], options);
+    }
+
+    std::vector<std::thread> threads;
+    threads.reserve(workers);
+    for (int i = 0; i < workers; ++i) {
+        threads.emplace_back(runWorker, i, serverFds[i], std::cref(options));
+    }
+
+    for (auto &thread: threads) {
+        thread.join();
+    }
+
+    return 0;
 }
@@ -1,11 +1,54 @@
 #include "../include/bang.h"
+#include "../include/bang_snapshot.h"
+#include "../include/bang_table.h"
+#include "../include/http_client.h"
 #include "../include/http_handler.h"
+#include "../include/mapped_file.h"
+#include "../include/parallel.h"
 #include <iostream>
-#include <fstream>
 #include <cstdlib>
 #include <filesystem>
 
-absl::flat_hash_map<std::string, Bang> ALL_BANGS = {};
+namespace {
+    absl::flat_hash_map<std::string, Bang> ALL_BANGS = {};
+    // Bangs from the last successful URL load, which a reload layers the custom bangs over again, and the validators
+    // that let a refresh skip fetching and parsing them when they have not changed
+    absl::flat_hash_map<std::string, Bang> URL_BANGS = {};
+    HttpValidators URL_VALIDATORS;
+    // Set while the published table was restored as is, from a snapshot or the binary, with nothing layered over it.
+    // Both maps above are then left empty and stand for exactly that table's bangs, so a restart does not copy every
+    // bang twice more before serving; the first load that needs them builds them from the table.
+    bool BANG_MAPS_DEFERRED = false;
+
+    // Only the loading thread replaces the published table, so it can still read the one the maps were deferred to
+    void expandDeferredBangMaps() {
+        if (!BANG_MAPS_DEFERRED) return;
+        BANG_MAPS_DEFERRED = false;
+
+        const BangTable &table = bangTable();
+        URL_BANGS.reserve(table.size());
+        for (const Bang &bang: table.bangs()) {
+            URL_BANGS[bang.trigger] = bang;
+        }
+        ALL_BANGS = URL_BANGS;
+    }
+
+    // Publishes a table of bangs and makes them ALL_BANGS, or leaves both as they were if the table cannot be built
+    bool publishBangs(absl::flat_hash_map<std::string, Bang> bangs) {
+        auto table = std::make_unique<BangTable>();
+        table->build(bangs);
+        if (table->size() != bangs.size()) return false;
+
+        ALL_BANGS = std::move(bangs);
+        publishBangTable(std::move(table));
+        return true;
+    }
+}
+
+const absl::flat_hash_map<std::string, Bang> &allBangs() {
+    expandDeferredBangMaps();
+    return ALL_BANGS;
+}
 
 const std::unordered_map<std::string_view, Category> CATEGORY_MAP = {
     {"Entertainment", Category::Entertainment},
@@ -26,194 +69,373 @@ std::string getCustomBangsFilePath() {
     return "bangs.json";
 }
 
-int processBangJsonArray(const simdjson::dom::array &items, bool isOverride) {
-    try {
-        size_t addedCount = 0;
-        simdjson::error_code error;
+namespace {
+    // Entries per chunk when compiling in parallel; below this a thread costs more than it saves
+    constexpr size_t COMPILE_CHUNK = 4096;
+
+    // One entry of a bangs array as read from the JSON. The strings point into the parser's buffers, so entries only
+    // live as long as the document they came from.
+    struct BangEntry {
+        std::optional<std::string_view> trigger;
+        std::optional<std::string_view> url_template;
+        std::optional<std::string_view> category;
+        std::optional<std::string_view> domain;
+        std::optional<uint64_t> relevance;
+        std::optional<std::string_view> short_name;
+        std::optional<std::string_view> subcategory;
+    };
+
+    std::optional<std::string_view> readString(simdjson::simdjson_result<simdjson::ondemand::value> value) {
+        std::string_view string;
+        if (value.get_string().get(string)) return std::nullopt;
+        return string;
+    }
 
-        for (simdjson::dom::element item: items) {
-            auto trigger = std::string("!");
+    std::optional<uint64_t> readRelevance(simdjson::simdjson_result<simdjson::ondemand::value> value) {
+        simdjson::ondemand::number_type type;
+        if (value.get_number_type().get(type)) return std::nullopt;
+        if (type == simdjson::ondemand::number_type::unsigned_integer) {
+            uint64_t relevance;
+            if (!value.get_uint64().get(relevance)) return relevance;
+        } else if (type == simdjson::ondemand::number_type::signed_integer) {
+            int64_t relevance;
+            if (!value.get_int64().get(relevance)) return static_cast<uint64_t>(relevance);
+        }
+        return std::nullopt;
+    }
 
-            std::string_view t;
-            error = item["t"].get_string().get(t);
-            if (error) {
-                std::cerr << "Missing required 'trigger' field in bang entry" << std::endl;
+    // Reads the bangs array in json On-Demand: one pass over the document, visiting every field of every entry once,
+    // in whatever order they come. Fields of the wrong type count as missing, and entries that are not objects are
+    // skipped. Returns the first syntax error, in which case entries is incomplete.
+    simdjson::error_code parseBangArray(simdjson::ondemand::parser &parser, const simdjson::padded_string_view json,
+                                        std::vector<BangEntry> &entries) {
+        simdjson::ondemand::document document;
+        simdjson::ondemand::array items;
+        if (const auto error = parser.iterate(json).get(document)) return error;
+        if (const auto error = document.get_array().get(items)) return error;
+
+        for (auto item: items) {
+            simdjson::ondemand::object object;
+            if (const auto error = item.get_object().get(object)) {
+                if (error != simdjson::INCORRECT_TYPE) return error;
+                entries.emplace_back();
                 continue;
             }
-            std::string trigger_value(t);
-            trigger += trigger_value;
 
-            std::string_view u;
-            error = item["u"].get_string().get(u);
-            if (error) {
-                std::cerr << "Missing required 'url_template' field in bang entry" << std::endl;
-                continue;
-            }
-            auto url_template = std::string(u);
-
-            // Optional fields
-            std::optional<Category> category;
-            std::string_view c;
-            error = item["c"].get_string().get(c);
-            if (!error) {
-                if (auto it = CATEGORY_MAP.find(c); it != CATEGORY_MAP.end()) {
-                    category = it->second;
-                }
+            BangEntry &entry = entries.emplace_back();
+            for (auto field: object) {
+                std::string_view key;
+                if (const auto error = field.unescaped_key().get(key)) return error;
+
+                // Of repeated keys the first one counts, as with a lookup by key
+                if (key == "t" && !entry.trigger) entry.trigger = readString(field.value());
+                else if (key == "u" && !entry.url_template) entry.url_template = readString(field.value());
+                else if (key == "c" && !entry.category) entry.category = readString(field.value());
+                else if (key == "d" && !entry.domain) entry.domain = readString(field.value());
+                else if (key == "r" && !entry.relevance) entry.relevance = readRelevance(field.value());
+                else if (key == "s" && !entry.short_name) entry.short_name = readString(field.value());
+                else if (key == "sc" && !entry.subcategory) entry.subcategory = readString(field.value());
             }
+        }
+        return document.at_end() ? simdjson::SUCCESS : simdjson::TRAILING_CONTENT;
+    }
 
-            std::optional<std::string> domain;
-            std::string_view d;
-            error = item["d"].get_string().get(d);
-            if (!error) {
-                domain = std::string(d);
+    Bang compileBang(const BangEntry &entry) {
+        std::optional<Category> category;
+        if (entry.category) {
+            if (auto it = CATEGORY_MAP.find(*entry.category); it != CATEGORY_MAP.end()) {
+                category = it->second;
             }
+        }
 
-            if (domain && !domain->starts_with("http")) {
+        std::optional<std::string> domain;
+        if (entry.domain) {
+            domain = std::string(*entry.domain);
+            if (!domain->starts_with("http")) {
                 domain->insert(0, "https://");
             }
+        }
 
-            std::optional<uint64_t> relevance;
-            uint64_t r_val;
-            error = item["r"].get_uint64().get(r_val);
-            if (!error) {
-                relevance = r_val;
-            } else {
-                int64_t r_int;
-                error = item["r"].get_int64().get(r_int);
-                if (!error) {
-                    relevance = static_cast<uint64_t>(r_int);
-                }
-            }
+        Bang bang(
+            category,
+            std::move(domain),
+            entry.relevance,
+            entry.short_name ? std::optional<std::string>(*entry.short_name) : std::nullopt,
+            entry.subcategory ? std::optional<std::string>(*entry.subcategory) : std::nullopt,
+            "!" + std::string(*entry.trigger),
+            std::string(*entry.url_template)
+        );
+        bang.redirect = compileRedirectTemplate(bang.url_template);
+        if (bang.domain) {
+            bang.domainRedirect = renderFixedRedirect(*bang.domain);
+        }
+        return bang;
+    }
+}
 
-            std::optional<std::string> short_name;
-            std::string_view s;
-            error = item["s"].get_string().get(s);
-            if (!error) {
-                short_name = std::string(s);
+// Compiles entries into bangs, chunks of them in parallel, and adds them in order, so of two with the same trigger the
+// later one wins. Returns how many were added, or -1 if they could not be processed.
+int processBangEntries(const std::vector<BangEntry> &entries, bool isOverride,
+                       absl::flat_hash_map<std::string, Bang> &bangs) {
+    try {
+        std::vector<const BangEntry *> valid;
+        valid.reserve(entries.size());
+        for (const BangEntry &entry: entries) {
+            if (!entry.trigger) {
+                std::cerr << "Missing required 'trigger' field in bang entry" << std::endl;
+            } else if (!entry.url_template) {
+                std::cerr << "Missing required 'url_template' field in bang entry" << std::endl;
+            } else {
+                valid.push_back(&entry);
             }
+        }
 
-            std::optional<std::string> subcategory;
-            std::string_view sc;
-            error = item["sc"].get_string().get(sc);
-            if (!error) {
-                subcategory = std::string(sc);
+        std::vector<Bang> compiled(valid.size());
+        parallelChunks(valid.size(), COMPILE_CHUNK, [&](const size_t begin, const size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                compiled[i] = compileBang(*valid[i]);
             }
+        });
 
-            Bang bang(
-                category,
-                domain,
-                relevance,
-                short_name,
-                subcategory,
-                trigger,
-                url_template
-            );
-
-            ALL_BANGS[trigger] = std::move(bang);
-            
+        bangs.reserve(bangs.size() + compiled.size());
+        for (Bang &bang: compiled) {
             if (isOverride) {
-                std::cout << "Overridden bang command: " << trigger << "\n";
+                std::cout << "Overridden bang command: " << bang.trigger << "\n";
             }
-
-            addedCount++;
+            std::string trigger = bang.trigger;
+            bangs[std::move(trigger)] = std::move(bang);
         }
 
-        return addedCount;
+        return static_cast<int>(compiled.size());
     } catch (const std::exception &e) {
         std::cerr << "Error processing bang data: " << e.what() << std::endl;
-        return false;
+        return -1;
     }
 }
 
-bool loadBangDataFromUrl(const std::string &url) {
-    try {
-        simdjson::dom::parser parser;
-
-        const std::string json_str = makeHttpRequest(url, "application/json");
+int parseBangData(const simdjson::padded_string_view json, absl::flat_hash_map<std::string, Bang> &bangs) {
+    simdjson::ondemand::parser parser;
+    std::vector<BangEntry> entries;
+    if (const auto error = parseBangArray(parser, json, entries)) {
+        std::cerr << "JSON parse error: " << error_message(error) << std::endl;
+        return -1;
+    }
+    return processBangEntries(entries, false, bangs);
+}
 
-        if (json_str.empty()) {
-            return false;
+// Fetches the bangs at url into bangs, as a conditional request when previous holds validators. Returns how many
+// were added along with the new validators, 0 if the copy previous describes is still current and -1 on errors.
+int fetchBangs(const std::string &url, const HttpValidators &previous, absl::flat_hash_map<std::string, Bang> &bangs,
+               HttpValidators &validators) {
+    try {
+        HttpResponse response = httpGet(url, "application/json", previous);
+        if (response.status == 304) {
+            return 0;
         }
-
-        const auto json_result = parser.parse(json_str);
-        simdjson::dom::element json;
-        auto error = json_result.get(json);
-        if (error) {
-            std::cerr << "JSON parse error: " << error_message(error) << std::endl;
-            return false;
+        if (response.status != 200) {
+            if (response.status != 0) {
+                std::cerr << "Unexpected HTTP status " << response.status << " from " << url << std::endl;
+            }
+            return -1;
         }
-
-        simdjson::dom::array items;
-        error = json.get_array().get(items);
-        if (error) {
-            std::cerr << "JSON not an array: " << error_message(error) << std::endl;
-            return false;
+        // Servers that ignore the condition still give the same ETag for the same data
+        if (!previous.etag.empty() && response.validators.etag == previous.etag) {
+            return 0;
         }
 
-        if (const int added = processBangJsonArray(items, false); added > 0) {
-            std::cout << "Loaded " << added << " bang commands from URL" << std::endl;
-            return true;
+        if (response.body.empty()) {
+            std::cerr << "Error: Empty response from server\n";
+            return -1;
         }
 
-        return false;
+        // Pads the body in place (it has the capacity more often than not) rather than copying it
+        response.body.reserve(response.body.size() + simdjson::SIMDJSON_PADDING);
+        const int added = parseBangData(simdjson::padded_string_view(response.body), bangs);
+        if (added <= 0) return -1;
+
+        std::cout << "Loaded " << added << " bang commands from URL" << std::endl;
+        validators = response.validators;
+        return added;
     } catch (const simdjson::simdjson_error &e) {
         std::cerr << "JSON parsing error: " << e.what() << std::endl;
-        return false;
+        return -1;
     } catch (const std::exception &e) {
         std::cerr << "Error loading bang data from URL: " << e.what() << std::endl;
+        return -1;
+    }
+}
+
+bool loadBangDataFromUrl(const std::string &url) {
+    absl::flat_hash_map<std::string, Bang> loaded;
+    if (fetchBangs(url, {}, loaded, URL_VALIDATORS) <= 0) {
         return false;
     }
+
+    expandDeferredBangMaps();
+    for (const auto &[trigger, bang]: loaded) {
+        ALL_BANGS[trigger] = bang;
+    }
+    URL_BANGS = std::move(loaded);
+    rebuildBangTable();
+    return true;
 }
 
-bool loadBangDataFromFile(const std::string &filePath) {
+int readBangFile(const std::string &filePath, absl::flat_hash_map<std::string, Bang> &bangs);
+
+bool refreshBangDataFromUrl(const std::string &url, const std::string &customBangsPath) {
+    absl::flat_hash_map<std::string, Bang> loaded;
+    HttpValidators validators;
+    if (const int added = fetchBangs(url, URL_VALIDATORS, loaded, validators); added <= 0) {
+        if (added == 0) {
+            std::cout << "Bangs at " << url << " are unchanged" << std::endl;
+        }
+        return false;
+    }
+
+    // The custom bangs are read aside: if they fail to load, the new URL bangs are still served, just without them
+    absl::flat_hash_map<std::string, Bang> custom;
+    if (readBangFile(customBangsPath, custom) < 0) {
+        std::cerr << "Serving the refreshed bangs without the custom ones" << std::endl;
+        custom.clear();
+    }
+    absl::flat_hash_map<std::string, Bang> bangs = loaded;
+    for (auto &[trigger, bang]: custom) {
+        bangs[trigger] = std::move(bang);
+    }
+
+    // Until they are published the validators stay those of the bangs being served, so the next refresh fetches again.
+    // Both maps are replaced here, so any deferred to the current table need not be expanded first.
+    if (!publishBangs(std::move(bangs))) {
+        std::cerr << "Failed to build the table of the refreshed bangs, keeping the current ones" << std::endl;
+        return false;
+    }
+    URL_BANGS = std::move(loaded);
+    URL_VALIDATORS = std::move(validators);
+    BANG_MAPS_DEFERRED = false;
+
+    std::cout << "Reloaded bangs, " << ALL_BANGS.size() << " in total" << std::endl;
+    return true;
+}
+
+bool loadBangDataFromSnapshot(const std::string &path) {
+    HttpValidators validators;
+    std::unique_ptr<BangTable> table = readBangSnapshot(path, validators);
+    if (!table) return false;
+
+    std::cout << "Loaded " << table->size() << " bang commands from snapshot: " << path << std::endl;
+    loadBangDataFromTable(std::move(table), validators);
+    return true;
+}
+
+void loadBangDataFromTable(std::unique_ptr<BangTable> table, const HttpValidators &validators) {
+    URL_VALIDATORS = validators;
+
+    // The table covers exactly these bangs, so unless others were loaded first it is served as is
+    if (ALL_BANGS.empty() && !BANG_MAPS_DEFERRED) {
+        URL_BANGS.clear();
+        publishBangTable(std::move(table));
+        BANG_MAPS_DEFERRED = true;
+        return;
+    }
+
+    expandDeferredBangMaps();
+    URL_BANGS.clear();
+    URL_BANGS.reserve(table->size());
+    for (const Bang &bang: table->bangs()) {
+        URL_BANGS[bang.trigger] = bang;
+    }
+    for (const auto &[trigger, bang]: URL_BANGS) {
+        ALL_BANGS[trigger] = bang;
+    }
+    rebuildBangTable();
+}
+
+bool saveBangSnapshot(const std::string &path) {
+    if (BANG_MAPS_DEFERRED) {
+        // Nothing is layered over the published table, so it holds the URL bangs alone
+        return writeBangSnapshot(path, bangTable(), URL_VALIDATORS);
+    }
+
+    BangTable table;
+    table.build(URL_BANGS);
+    return table.size() == URL_BANGS.size() && !URL_BANGS.empty() && writeBangSnapshot(path, table, URL_VALIDATORS);
+}
+
+// Adds the custom bangs in filePath to bangs. Returns how many were added, 0 if there is no such file and -1 if it
+// could not be read or parsed.
+int readBangFile(const std::string &filePath, absl::flat_hash_map<std::string, Bang> &bangs) {
     try {
         if (!std::filesystem::exists(filePath)) {
             std::cout << "Custom bangs file not found at: " << filePath << std::endl;
-            return false;
+            return 0;
         }
 
-        std::ifstream file(filePath);
-        if (!file.is_open()) {
+        // Parsed straight from the page cache: the mapping carries simdjson's padding, so nothing is copied
+        const MappedFile file(filePath, simdjson::SIMDJSON_PADDING);
+        if (!file.data()) {
             std::cerr << "Failed to open custom bangs file: " << filePath << std::endl;
-            return false;
+            return -1;
         }
 
-        std::string json_str((std::istreambuf_iterator(file)), std::istreambuf_iterator<char>());
-        file.close();
-
-        if (json_str.empty()) {
+        if (file.size() == 0) {
             std::cerr << "Custom bangs file is empty: " << filePath << std::endl;
-            return false;
-        }
-
-        simdjson::dom::parser parser;
-        auto json_result = parser.parse(json_str);
-        simdjson::dom::element json;
-        auto error = json_result.get(json);
-        if (error) {
-            std::cerr << "JSON parse error in custom bangs file: " << error_message(error) << std::endl;
-            return false;
+            return -1;
         }
 
-        simdjson::dom::array items;
-        error = json.get_array().get(items);
-        if (error) {
-            std::cerr << "Custom bangs file must contain a JSON array: " << error_message(error) << std::endl;
-            return false;
+        simdjson::ondemand::parser parser;
+        std::vector<BangEntry> entries;
+        const simdjson::padded_string_view json(file.data(), file.size(), file.size() + simdjson::SIMDJSON_PADDING);
+        if (const auto error = parseBangArray(parser, json, entries)) {
+            if (error == simdjson::INCORRECT_TYPE && entries.empty()) {
+                std::cerr << "Custom bangs file must contain a JSON array: " << error_message(error) << std::endl;
+            } else {
+                std::cerr << "JSON parse error in custom bangs file: " << error_message(error) << std::endl;
+            }
+            return -1;
         }
 
-        if (const int added = processBangJsonArray(items, true); added > 0) {
+        const int added = processBangEntries(entries, true, bangs);
+        if (added > 0) {
             std::cout << "Loaded " << added << " custom bang commands from: " << filePath <<
                     std::endl;
-            return true;
         }
-
-        return false;
+        return added;
     } catch (const simdjson::simdjson_error &e) {
         std::cerr << "JSON parsing error in custom bangs file: " << e.what() << std::endl;
-        return false;
+        return -1;
     } catch (const std::exception &e) {
         std::cerr << "Error loading custom bang data from file: " << e.what() << std::endl;
+        return -1;
+    }
+}
+
+bool loadBangDataFromFile(const std::string &filePath) {
+    // Read aside, so bangs deferred to their table are only expanded when there are custom ones to layer over them
+    absl::flat_hash_map<std::string, Bang> custom;
+    if (readBangFile(filePath, custom) <= 0) {
+        return false;
+    }
+
+    expandDeferredBangMaps();
+    for (auto &[trigger, bang]: custom) {
+        ALL_BANGS[trigger] = std::move(bang);
+    }
+    rebuildBangTable();
+    return true;
+}
+
+bool reloadBangDataFromFile(const std::string &filePath) {
+    expandDeferredBangMaps();
+
+    // Built aside, so a file that fails to parse (say, saved halfway through an edit) leaves everything as it was
+    absl::flat_hash_map<std::string, Bang> bangs = URL_BANGS;
+    if (readBangFile(filePath, bangs) < 0) {
+        std::cerr << "Keeping the current bangs" << std::endl;
         return false;
     }
+
+    if (!publishBangs(std::move(bangs))) return false;
+
+    std::cout << "Reloaded bangs, " << ALL_BANGS.size() << " in total" << std::endl;
+    return true;
 }
@@ -0,0 +1,309 @@
+#include "../include/bang_snapshot.h"
+#include "../include/mapped_file.h"
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <type_traits>
+
+namespace {
+    constexpr char SNAPSHOT_MAGIC[8] = {'B', 'A', 'N', 'G', 'S', 'N', 'A', 'P'};
+    constexpr uint32_t SNAPSHOT_VERSION = 1;
+    constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+    constexpr uint32_t ABSENT = UINT32_MAX; // Offset of an optional string that is not set
+    constexpr size_t SECTION_ALIGNMENT = 64;
+
+    struct SnapshotString {
+        uint32_t offset;
+        uint32_t length;
+    };
+
+    struct SnapshotBang {
+        SnapshotString trigger;
+        SnapshotString urlTemplate;
+        SnapshotString domain;
+        SnapshotString shortName;
+        SnapshotString subcategory;
+        SnapshotString redirectHead;
+        SnapshotString redirectTail;
+        SnapshotString domainRedirectHead; // ABSENT without a domain redirect
+        SnapshotString domainRedirectTail;
+        uint64_t relevance;
+        int32_t category; // -1 if none
+        uint32_t hasRelevance;
+    };
+
+    struct SnapshotHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t byteOrder;
+        uint64_t fileSize;
+        uint64_t checksum; // Of everything after the header
+        uint64_t bangCount;
+        uint64_t seed;
+        uint64_t buckets;
+        uint64_t denseBuckets;
+        uint64_t maxRedirectSize;
+        uint64_t pilotsOffset;
+        uint64_t slotsOffset;
+        uint64_t bangsOffset;
+        uint64_t arenaOffset;
+        uint64_t arenaSize;
+        SnapshotString etag;
+        SnapshotString lastModified;
+    };
+
+    static_assert(std::is_trivially_copyable_v<SnapshotHeader> && std::is_trivially_copyable_v<SnapshotBang> &&
+                  std::is_trivially_copyable_v<BangSlot>);
+
+    size_t alignSection(const size_t offset) {
+        return (offset + SECTION_ALIGNMENT - 1) & ~(SECTION_ALIGNMENT - 1);
+    }
+
+    // Word-at-a-time, so checking a few MiB stays well under a millisecond; it only has to catch damage, not attacks
+    uint64_t checksumOf(const char *data, const size_t size) {
+        uint64_t hash = 0x9E3779B97F4A7C15ULL ^ size;
+        size_t i = 0;
+        for (; i + 8 <= size; i += 8) {
+            uint64_t word;
+            memcpy(&word, data + i, 8);
+            hash = (hash ^ word) * 0xff51afd7ed558ccdULL;
+            hash ^= hash >> 32;
+        }
+        uint64_t tail = 0;
+        memcpy(&tail, data + i, size - i);
+        hash = (hash ^ tail) * 0xc4ceb9fe1a85ec53ULL;
+        return hash ^ hash >> 29;
+    }
+
+    class ArenaWriter {
+    public:
+        SnapshotString add(const std::string_view value) {
+            const SnapshotString reference{static_cast<uint32_t>(m_arena.size()), static_cast<uint32_t>(value.size())};
+            m_arena += value;
+            return reference;
+        }
+
+        SnapshotString addOptional(const std::optional<std::string> &value) {
+            return value ? add(*value) : SnapshotString{ABSENT, 0};
+        }
+
+        [[nodiscard]] const std::string &arena() const { return m_arena; }
+
+    private:
+        std::string m_arena;
+    };
+
+    class ArenaReader {
+    public:
+        ArenaReader(const char *arena, const size_t size) : m_arena(arena), m_size(size) {
+        }
+
+        [[nodiscard]] bool valid(const SnapshotString reference, const bool optional = false) const {
+            if (reference.offset == ABSENT) return optional;
+            return reference.offset <= m_size && reference.length <= m_size - reference.offset;
+        }
+
+        [[nodiscard]] std::string get(const SnapshotString reference) const {
+            return {m_arena + reference.offset, reference.length};
+        }
+
+        [[nodiscard]] std::optional<std::string> getOptional(const SnapshotString reference) const {
+            if (reference.offset == ABSENT) return std::nullopt;
+            return get(reference);
+        }
+
+    private:
+        const char *m_arena;
+        size_t m_size;
+    };
+
+    bool validSection(const SnapshotHeader &header, const uint64_t offset, const uint64_t count, const size_t size) {
+        return offset % SECTION_ALIGNMENT == 0 && offset >= sizeof(SnapshotHeader) && offset <= header.fileSize &&
+               count <= (header.fileSize - offset) / size;
+    }
+
+    // Writes bytes to a new file at path and syncs it to disk; errno tells what failed if it returns false
+    bool writeDurably(const std::string &path, const std::string_view bytes) {
+        const int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0) return false;
+        size_t written = 0;
+        while (written < bytes.size()) {
+            const ssize_t result = write(fd, bytes.data() + written, bytes.size() - written);
+            if (result < 0 && errno == EINTR) continue;
+            if (result < 0) break;
+            written += result;
+        }
+        const bool synced = written == bytes.size() && fsync(fd) == 0;
+        const int savedErrno = errno;
+        close(fd);
+        errno = savedErrno;
+        return synced;
+    }
+}
+
+bool writeBangSnapshot(const std::string &path, const BangTable &table, const HttpValidators &validators) {
+    ArenaWriter arena;
+    std::vector<SnapshotBang> records;
+    records.reserve(table.m_bangs.size());
+    for (const Bang &bang: table.m_bangs) {
+        SnapshotBang record{};
+        record.trigger = arena.add(bang.trigger);
+        record.urlTemplate = arena.add(bang.url_template);
+        record.domain = arena.addOptional(bang.domain);
+        record.shortName = arena.addOptional(bang.short_name);
+        record.subcategory = arena.addOptional(bang.subcategory);
+        record.redirectHead = arena.add(bang.redirect.head);
+        record.redirectTail = arena.add(bang.redirect.tail);
+        if (bang.domainRedirect) {
+            record.domainRedirectHead = arena.add(bang.domainRedirect->head);
+            record.domainRedirectTail = arena.add(bang.domainRedirect->tail);
+        } else {
+            record.domainRedirectHead = record.domainRedirectTail = SnapshotString{ABSENT, 0};
+        }
+        record.relevance = bang.relevance.value_or(0);
+        record.hasRelevance = bang.relevance.has_value();
+        record.category = bang.category ? static_cast<int32_t>(*bang.category) : -1;
+        records.push_back(record);
+    }
+
+    SnapshotHeader header{};
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.byteOrder = BYTE_ORDER_MARK;
+    header.bangCount = table.m_bangs.size();
+    header.seed = table.m_seed;
+    header.buckets = table.m_buckets;
+    header.denseBuckets = table.m_denseBuckets;
+    header.maxRedirectSize = table.m_maxRedirectSize;
+    header.etag = arena.add(validators.etag);
+    header.lastModified = arena.add(validators.lastModified);
+
+    header.pilotsOffset = alignSection(sizeof(SnapshotHeader));
+    header.slotsOffset = alignSection(header.pilotsOffset + table.m_pilots.size() * sizeof(uint64_t));
+    header.bangsOffset = alignSection(header.slotsOffset + table.m_slots.size() * sizeof(BangSlot));
+    header.arenaOffset = alignSection(header.bangsOffset + records.size() * sizeof(SnapshotBang));
+    header.arenaSize = arena.arena().size();
+    header.fileSize = header.arenaOffset + header.arenaSize;
+    if (header.arenaSize >= ABSENT) {
+        std::cerr << "Bangs too large for a snapshot" << std::endl;
+        return false;
+    }
+
+    std::string image(header.fileSize, '\0');
+    memcpy(image.data() + header.pilotsOffset, table.m_pilots.data(), table.m_pilots.size() * sizeof(uint64_t));
+    memcpy(image.data() + header.slotsOffset, table.m_slots.data(), table.m_slots.size() * sizeof(BangSlot));
+    memcpy(image.data() + header.bangsOffset, records.data(), records.size() * sizeof(SnapshotBang));
+    memcpy(image.data() + header.arenaOffset, arena.arena().data(), header.arenaSize);
+    header.checksum = checksumOf(image.data() + sizeof(SnapshotHeader), image.size() - sizeof(SnapshotHeader));
+    memcpy(image.data(), &header, sizeof(header));
+
+    // The data reaches the disk before the rename does, or a crash could leave an empty file under the snapshot's name
+    const std::string temporaryPath = path + ".tmp";
+    std::error_code error;
+    if (!writeDurably(temporaryPath, image)) {
+        std::cerr << "Failed to write bang snapshot " << temporaryPath << ": " << strerror(errno) << std::endl;
+        std::filesystem::remove(temporaryPath, error);
+        return false;
+    }
+
+    std::filesystem::rename(temporaryPath, path, error);
+    if (error) {
+        std::cerr << "Failed to replace bang snapshot " << path << ": " << error.message() << std::endl;
+        std::filesystem::remove(temporaryPath, error);
+        return false;
+    }
+
+    // And the rename itself only lasts once the directory holding it is synced
+    std::filesystem::path directory = std::filesystem::path(path).parent_path();
+    if (directory.empty()) directory = ".";
+    const int directoryFd = open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (directoryFd < 0 || fsync(directoryFd) != 0) {
+        std::cerr << "Failed to sync bang snapshot directory " << directory.string() << ": " << strerror(errno)
+                << std::endl;
+        if (directoryFd >= 0) close(directoryFd);
+        return false;
+    }
+    close(directoryFd);
+    return true;
+}
+
+std::unique_ptr<BangTable> readBangSnapshot(const std::string &path, HttpValidators &validators) {
+    const MappedFile file(path);
+    if (!file.data()) return nullptr;
+
+    SnapshotHeader header{};
+    if (file.size() < sizeof(header)) {
+        std::cerr << "Ignoring truncated bang snapshot: " << path << std::endl;
+        return nullptr;
+    }
+    memcpy(&header, file.data(), sizeof(header));
+
+    if (memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0 || header.version != SNAPSHOT_VERSION ||
+        header.byteOrder != BYTE_ORDER_MARK) {
+        std::cerr << "Ignoring bang snapshot from another version or machine: " << path << std::endl;
+        return nullptr;
+    }
+    if (header.fileSize != file.size() ||
+        checksumOf(file.data() + sizeof(header), file.size() - sizeof(header)) != header.checksum) {
+        std::cerr << "Ignoring damaged bang snapshot: " << path << std::endl;
+        return nullptr;
+    }
+    // Damage is ruled out by now; these checks keep a snapshot written by a broken build from reading out of bounds
+    if (header.bangCount == 0 || header.buckets == 0 || header.denseBuckets > header.buckets ||
+        !validSection(header, header.pilotsOffset, header.buckets, sizeof(uint64_t)) ||
+        !validSection(header, header.slotsOffset, header.bangCount, sizeof(BangSlot)) ||
+        !validSection(header, header.bangsOffset, header.bangCount, sizeof(SnapshotBang)) ||
+        !validSection(header, header.arenaOffset, header.arenaSize, 1)) {
+        std::cerr << "Ignoring malformed bang snapshot: " << path << std::endl;
+        return nullptr;
+    }
+
+    const ArenaReader arena(file.data() + header.arenaOffset, header.arenaSize);
+    if (!arena.valid(header.etag) || !arena.valid(header.lastModified)) {
+        std::cerr << "Ignoring malformed bang snapshot: " << path << std::endl;
+        return nullptr;
+    }
+
+    auto table = std::make_unique<BangTable>();
+    table->m_seed = header.seed;
+    table->m_buckets = header.buckets;
+    table->m_denseBuckets = header.denseBuckets;
+    table->m_maxRedirectSize = header.maxRedirectSize;
+    table->m_pilots.resize(header.buckets);
+    memcpy(table->m_pilots.data(), file.data() + header.pilotsOffset, header.buckets * sizeof(uint64_t));
+    table->m_slots.resize(header.bangCount);
+    memcpy(table->m_slots.data(), file.data() + header.slotsOffset, header.bangCount * sizeof(BangSlot));
+
+    table->m_bangs.resize(header.bangCount);
+    for (size_t i = 0; i < header.bangCount; ++i) {
+        SnapshotBang record;
+        memcpy(&record, file.data() + header.bangsOffset + i * sizeof(SnapshotBang), sizeof(record));
+        if (!arena.valid(record.trigger) || !arena.valid(record.urlTemplate) || !arena.valid(record.domain, true) ||
+            !arena.valid(record.shortName, true) || !arena.valid(record.subcategory, true) ||
+            !arena.valid(record.redirectHead) || !arena.valid(record.redirectTail) ||
+            !arena.valid(record.domainRedirectHead, true) || !arena.valid(record.domainRedirectTail, true) ||
+            record.category < -1 || record.category > static_cast<int32_t>(Category::Translation)) {
+            std::cerr << "Ignoring malformed bang snapshot: " << path << std::endl;
+            return nullptr;
+        }
+
+        Bang &bang = table->m_bangs[i];
+        bang.trigger = arena.get(record.trigger);
+        bang.url_template = arena.get(record.urlTemplate);
+        bang.domain = arena.getOptional(record.domain);
+        bang.short_name = arena.getOptional(record.shortName);
+        bang.subcategory = arena.getOptional(record.subcategory);
+        bang.redirect = {arena.get(record.redirectHead), arena.get(record.redirectTail)};
+        if (record.domainRedirectHead.offset != ABSENT && record.domainRedirectTail.offset != ABSENT) {
+            bang.domainRedirect = RedirectTemplate{arena.get(record.domainRedirectHead),
+                                                   arena.get(record.domainRedirectTail)};
+        }
+        if (record.hasRelevance) bang.relevance = record.relevance;
+        if (record.category >= 0) bang.category = static_cast<Category>(record.category);
+    }
+
+    validators.etag = arena.get(header.etag);
+    validators.lastModified = arena.get(header.lastModified);
+    return table;
+}
@@ -0,0 +1,335 @@
+#include "../include/bang_table.h"
+#include "../include/parallel.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+#ifdef __x86_64__
+#include <immintrin.h>
+#endif
+
+namespace {
+    // Served until the first load publishes a real table
+    const BangTable EMPTY_BANG_TABLE;
+
+    // Bumped by every grace period; a reader records the value it saw when it last came online, 0 while offline
+    std::atomic<uint64_t> readerEpoch{1};
+
+    struct alignas(64) ReaderState {
+        std::atomic<uint64_t> epoch{0};
+    };
+
+    std::mutex readersMutex;
+    std::deque<ReaderState> readers; // A deque, so registering never moves a state a reader points to
+    thread_local constinit ReaderState *currentReader = nullptr;
+
+    std::atomic<size_t> widestRedirect{0};
+    std::mutex publishMutex;
+
+    constexpr unsigned char LONG_TRIGGER = 0xFF;
+    constexpr double BUCKETS_PER_KEY_FACTOR = 5.0; // c in PTHash: buckets = c * n / log2(n)
+    constexpr uint32_t DENSE_KEY_FRACTION = 0x99999999; // 60% of keys go to the first 30% of buckets
+    constexpr uint64_t PILOT_SEARCH_LIMIT = 1 << 22;
+    constexpr int BUILD_ATTEMPTS = 16;
+    // Keys per chunk when building in parallel: hashing is cheap enough that only large sets are worth splitting
+    constexpr size_t HASH_CHUNK = 1 << 16;
+    constexpr size_t COPY_CHUNK = 4096;
+
+    // Loading 16 bytes at LENGTH_MASK + 16 - length gives a mask that keeps the first length bytes
+    alignas(16) constexpr unsigned char LENGTH_MASK[32] = {
+        0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF
+    };
+
+    uint64_t mix(uint64_t x) {
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdULL;
+        x ^= x >> 33;
+        x *= 0xc4ceb9fe1a85ec53ULL;
+        x ^= x >> 33;
+        return x;
+    }
+
+    uint64_t fastRange(const uint64_t x, const uint64_t n) {
+        return static_cast<uint64_t>((static_cast<unsigned __int128>(x) * n) >> 64);
+    }
+
+    uint64_t hashWords(const uint64_t lo, const uint64_t hi, const uint64_t seed) {
+        return mix(lo ^ mix(hi ^ seed));
+    }
+
+    uint64_t hashLong(const std::string_view trigger, const uint64_t seed) {
+        uint64_t hash = seed ^ trigger.size();
+        size_t i = 0;
+        for (; i + 8 <= trigger.size(); i += 8) {
+            uint64_t word;
+            memcpy(&word, trigger.data() + i, 8);
+            hash = mix(hash ^ word);
+        }
+        uint64_t tail = 0;
+        memcpy(&tail, trigger.data() + i, trigger.size() - i);
+        return mix(hash ^ tail);
+    }
+
+    BangSlot makeSlot(const std::string_view trigger) {
+        BangSlot slot{};
+        if (trigger.size() <= MAX_INLINE_TRIGGER) {
+            memcpy(slot.bytes, trigger.data(), trigger.size());
+            slot.bytes[15] = static_cast<unsigned char>(trigger.size());
+        } else {
+            memcpy(slot.bytes, trigger.data(), MAX_INLINE_TRIGGER);
+            slot.bytes[15] = LONG_TRIGGER;
+        }
+        return slot;
+    }
+
+    uint64_t hashTrigger(const std::string_view trigger, const uint64_t seed) {
+        if (trigger.size() > MAX_INLINE_TRIGGER) {
+            return hashLong(trigger, seed);
+        }
+        const BangSlot slot = makeSlot(trigger);
+        uint64_t words[2];
+        memcpy(words, slot.bytes, sizeof(words));
+        return hashWords(words[0], words[1], seed);
+    }
+}
+
+size_t BangTable::bucketOf(const uint64_t hash) const {
+    const uint64_t high = hash >> 32;
+    if (static_cast<uint32_t>(hash) < DENSE_KEY_FRACTION) {
+        return (high * m_denseBuckets) >> 32;
+    }
+    return m_denseBuckets + ((high * (m_buckets - m_denseBuckets)) >> 32);
+}
+
+size_t BangTable::slotOf(const uint64_t hash) const {
+    return fastRange(mix(hash ^ m_pilots[bucketOf(hash)]), m_slots.size());
+}
+
+void BangTable::build(const absl::flat_hash_map<std::string, Bang> &bangs) {
+    m_pilots.clear();
+    m_slots.clear();
+    m_bangs.clear();
+    m_maxRedirectSize = 0;
+
+    const size_t n = bangs.size();
+    if (n == 0) return;
+
+    std::vector<const Bang *> sources;
+    sources.reserve(n);
+    for (const auto &[trigger, bang]: bangs) {
+        sources.push_back(&bang);
+        m_maxRedirectSize = std::max(m_maxRedirectSize, bang.redirect.head.size() + bang.redirect.tail.size());
+        if (bang.domainRedirect) {
+            m_maxRedirectSize = std::max(m_maxRedirectSize,
+                                         bang.domainRedirect->head.size() + bang.domainRedirect->tail.size());
+        }
+    }
+
+    m_buckets = std::max<size_t>(1, static_cast<size_t>(std::ceil(
+                                        BUCKETS_PER_KEY_FACTOR * n / std::log2(static_cast<double>(n) + 1))));
+    m_denseBuckets = std::max<size_t>(1, m_buckets * 3 / 10);
+    if (m_denseBuckets == m_buckets && m_buckets > 1) --m_denseBuckets;
+    m_pilots.assign(m_buckets, 0);
+    m_slots.resize(n); // slotOf ranges over m_slots.size() while searching
+
+    std::vector<uint64_t> hashes(n);
+    std::vector<size_t> slotOfKey(n);
+    std::vector<size_t> bucketStart(m_buckets + 1);
+    std::vector<size_t> bucketKeys(n);
+    std::vector<size_t> bucketOrder(m_buckets);
+    std::vector<bool> taken(n);
+    std::vector<size_t> positions;
+
+    for (int attempt = 0; attempt < BUILD_ATTEMPTS; ++attempt) {
+        m_seed = mix(0x9E3779B97F4A7C15ULL + attempt);
+
+        parallelChunks(n, HASH_CHUNK, [&](const size_t begin, const size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                hashes[i] = hashTrigger(sources[i]->trigger, m_seed);
+            }
+        });
+
+        // Group keys by bucket (counting sort), then place the largest buckets first while most slots are free
+        std::fill(bucketStart.begin(), bucketStart.end(), 0);
+        for (size_t i = 0; i < n; ++i) {
+            ++bucketStart[bucketOf(hashes[i]) + 1];
+        }
+        for (size_t b = 0; b < m_buckets; ++b) {
+            bucketStart[b + 1] += bucketStart[b];
+        }
+        std::vector<size_t> fill(bucketStart.begin(), bucketStart.end() - 1);
+        for (size_t i = 0; i < n; ++i) {
+            bucketKeys[fill[bucketOf(hashes[i])]++] = i;
+        }
+
+        for (size_t b = 0; b < m_buckets; ++b) bucketOrder[b] = b;
+        std::ranges::stable_sort(bucketOrder, [&](const size_t a, const size_t b) {
+            return bucketStart[a + 1] - bucketStart[a] > bucketStart[b + 1] - bucketStart[b];
+        });
+
+        std::fill(taken.begin(), taken.end(), false);
+        std::fill(m_pilots.begin(), m_pilots.end(), 0);
+        bool placedAll = true;
+
+        for (const size_t bucket: bucketOrder) {
+            const size_t begin = bucketStart[bucket];
+            const size_t end = bucketStart[bucket + 1];
+            if (begin == end) break; // Sorted by size, so every remaining bucket is empty
+
+            bool placed = false;
+            for (uint64_t pilot = 0; pilot < PILOT_SEARCH_LIMIT && !placed; ++pilot) {
+                const uint64_t pilotHash = mix(pilot ^ m_seed);
+                positions.clear();
+
+                placed = true;
+                for (size_t k = begin; k < end; ++k) {
+                    const size_t slot = fastRange(mix(hashes[bucketKeys[k]] ^ pilotHash), n);
+                    if (taken[slot] || std::ranges::find(positions, slot) != positions.end()) {
+                        placed = false;
+                        break;
+                    }
+                    positions.push_back(slot);
+                }
+
+                if (placed) {
+                    m_pilots[bucket] = pilotHash;
+                    for (size_t k = begin; k < end; ++k) {
+                        taken[positions[k - begin]] = true;
+                        slotOfKey[bucketKeys[k]] = positions[k - begin];
+                    }
+                }
+            }
+
+            if (!placed) {
+                placedAll = false;
+                break;
+            }
+        }
+
+        if (placedAll) {
+            // Copying the bangs dominates the build; every key has a slot of its own, so chunks never collide
+            m_bangs.resize(n);
+            parallelChunks(n, COPY_CHUNK, [&](const size_t begin, const size_t end) {
+                for (size_t i = begin; i < end; ++i) {
+                    m_slots[slotOfKey[i]] = makeSlot(sources[i]->trigger);
+                    m_bangs[slotOfKey[i]] = *sources[i];
+                }
+            });
+            return;
+        }
+    }
+
+    std::cerr << "Failed to build the bang table for " << n << " bangs" << std::endl;
+    m_pilots.clear();
+    m_slots.clear();
+}
+
+const Bang *BangTable::find(const std::string_view trigger) const {
+    if (m_bangs.empty() || trigger.empty()) return nullptr;
+
+    const size_t length = trigger.size();
+    if (length > MAX_INLINE_TRIGGER) {
+        const size_t slot = slotOf(hashLong(trigger, m_seed));
+        if (m_slots[slot].bytes[15] == LONG_TRIGGER && m_bangs[slot].trigger == trigger) {
+            return &m_bangs[slot];
+        }
+        return nullptr;
+    }
+
+#ifdef __x86_64__
+    __m128i key;
+    if ((reinterpret_cast<uintptr_t>(trigger.data()) & 4095) <= 4096 - 16) {
+        // The 16-byte load stays inside the page, so reading past the end of the trigger cannot fault
+        key = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(trigger.data())),
+                            _mm_loadu_si128(reinterpret_cast<const __m128i *>(LENGTH_MASK + 16 - length)));
+    } else {
+        alignas(16) unsigned char bytes[16] = {};
+        memcpy(bytes, trigger.data(), length);
+        key = _mm_load_si128(reinterpret_cast<const __m128i *>(bytes));
+    }
+    key = _mm_or_si128(key, _mm_slli_si128(_mm_cvtsi32_si128(static_cast<int>(length)), 15));
+
+    const auto lo = static_cast<uint64_t>(_mm_cvtsi128_si64(key));
+    const auto hi = static_cast<uint64_t>(_mm_cvtsi128_si64(_mm_unpackhi_epi64(key, key)));
+    const size_t slot = slotOf(hashWords(lo, hi, m_seed));
+
+    const __m128i stored = _mm_load_si128(reinterpret_cast<const __m128i *>(m_slots[slot].bytes));
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(key, stored)) == 0xFFFF) {
+        return &m_bangs[slot];
+    }
+    return nullptr;
+#else
+    const BangSlot key = makeSlot(trigger);
+    const size_t slot = slotOf(hashTrigger(trigger, m_seed));
+    return memcmp(key.bytes, m_slots[slot].bytes, sizeof(key.bytes)) == 0 ? &m_bangs[slot] : nullptr;
+#endif
+}
+
+std::atomic<const BangTable *> PUBLISHED_BANG_TABLE{&EMPTY_BANG_TABLE};
+
+namespace {
+    // Returns once every reader has gone offline or come back online since the call, so none of them can still be
+    // using anything it saw before
+    void waitForReaders() {
+        const uint64_t epoch = readerEpoch.fetch_add(1, std::memory_order_seq_cst) + 1;
+
+        std::lock_guard lock(readersMutex);
+        for (const ReaderState &reader: readers) {
+            uint64_t seen;
+            while ((seen = reader.epoch.load(std::memory_order_seq_cst)) != 0 && seen < epoch) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+    }
+}
+
+size_t widestBangRedirect() {
+    return widestRedirect.load(std::memory_order_relaxed);
+}
+
+void publishBangTable(std::unique_ptr<const BangTable> table) {
+    std::lock_guard lock(publishMutex);
+
+    if (table->maxRedirectSize() > widestRedirect.load(std::memory_order_relaxed)) {
+        // Every request still sizing its response with the old bound finishes before the wider table can be seen
+        widestRedirect.store(table->maxRedirectSize(), std::memory_order_relaxed);
+        waitForReaders();
+    }
+
+    const BangTable *old = PUBLISHED_BANG_TABLE.exchange(table.release(), std::memory_order_seq_cst);
+    waitForReaders();
+    if (old != &EMPTY_BANG_TABLE) delete old;
+}
+
+bool rebuildBangTable() {
+    auto table = std::make_unique<BangTable>();
+    const absl::flat_hash_map<std::string, Bang> &bangs = allBangs();
+    table->build(bangs);
+    if (table->size() != bangs.size()) return false; // Keep serving the current table rather than an empty one
+
+    publishBangTable(std::move(table));
+    return true;
+}
+
+void registerBangTableReader() {
+    if (currentReader) return;
+
+    std::lock_guard lock(readersMutex);
+    currentReader = &readers.emplace_back();
+}
+
+void bangTableOnline() {
+    currentReader->epoch.store(readerEpoch.load(std::memory_order_acquire), std::memory_order_relaxed);
+    // Orders the store above before every table load that follows: either a reload waiting for readers sees this
+    // thread online, or this thread sees the table that reload published
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+void bangTableOffline() {
+    currentReader->epoch.store(0, std::memory_order_release);
+}
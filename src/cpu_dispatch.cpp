@@ -0,0 +1,49 @@
+#include "../include/cpu_dispatch.h"
+#include <iterator>
+
+namespace {
+    // Zero-initialized to Scalar before dynamic initialization, so kernels that run earlier are merely slower
+    SimdTier activeTier = detectSimdTier();
+
+    constexpr std::string_view TIER_NAMES[] = {"scalar", "sse4.2", "avx2", "avx512"};
+}
+
+SimdTier detectSimdTier() {
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+    // May run before the constructor that normally fills in the feature bits. The AVX checks include the OS
+    // enabling the wider register state (XGETBV).
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512vbmi") &&
+        __builtin_cpu_supports("avx512vbmi2")) {
+        return SimdTier::AVX512;
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("bmi") && __builtin_cpu_supports("bmi2")) {
+        return SimdTier::AVX2;
+    }
+    if (__builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("popcnt")) {
+        return SimdTier::SSE42;
+    }
+#endif
+    return SimdTier::Scalar;
+}
+
+SimdTier activeSimdTier() {
+    return activeTier;
+}
+
+bool setSimdTier(const SimdTier tier) {
+    if (tier > detectSimdTier()) return false;
+    activeTier = tier;
+    return true;
+}
+
+std::string_view simdTierName(const SimdTier tier) {
+    return TIER_NAMES[static_cast<int>(tier)];
+}
+
+std::optional<SimdTier> parseSimdTier(const std::string_view name) {
+    for (int i = 0; i < static_cast<int>(std::size(TIER_NAMES)); ++i) {
+        if (TIER_NAMES[i] == name) return static_cast<SimdTier>(i);
+    }
+    return std::nullopt;
+}
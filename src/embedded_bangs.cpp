@@ -0,0 +1,52 @@
+#include "../include/embedded_bangs.h"
+#include "../include/http_client.h"
+#include <iostream>
+
+namespace {
+    std::optional<std::string> optionalString(const std::string_view value) {
+        if (!value.data()) return std::nullopt;
+        return std::string(value);
+    }
+}
+
+std::unique_ptr<BangTable> embeddedBangTable() {
+    const EmbeddedBangTable &embedded = EMBEDDED_BANG_TABLE;
+    if (embedded.bangs.empty()) return nullptr;
+
+    auto table = std::make_unique<BangTable>();
+    table->m_seed = embedded.seed;
+    table->m_buckets = embedded.buckets;
+    table->m_denseBuckets = embedded.denseBuckets;
+    table->m_maxRedirectSize = embedded.maxRedirectSize;
+    table->m_pilots.assign(embedded.pilots.begin(), embedded.pilots.end());
+    table->m_slots.assign(embedded.slots.begin(), embedded.slots.end());
+
+    table->m_bangs.resize(embedded.bangs.size());
+    for (size_t i = 0; i < embedded.bangs.size(); ++i) {
+        const EmbeddedBang &source = embedded.bangs[i];
+        Bang &bang = table->m_bangs[i];
+        bang.trigger = source.trigger;
+        bang.url_template = source.url_template;
+        bang.domain = optionalString(source.domain);
+        bang.short_name = optionalString(source.short_name);
+        bang.subcategory = optionalString(source.subcategory);
+        bang.redirect = {std::string(source.redirectHead), std::string(source.redirectTail)};
+        if (source.domainRedirectHead.data()) {
+            bang.domainRedirect = RedirectTemplate{std::string(source.domainRedirectHead),
+                                                   std::string(source.domainRedirectTail)};
+        }
+        if (source.hasRelevance) bang.relevance = source.relevance;
+        if (source.category >= 0) bang.category = static_cast<Category>(source.category);
+    }
+    return table;
+}
+
+bool loadEmbeddedBangData() {
+    std::unique_ptr<BangTable> table = embeddedBangTable();
+    if (!table) return false;
+
+    std::cout << "Loaded " << table->size() << " built-in bang commands (from " << EMBEDDED_BANG_TABLE.source << ")"
+            << std::endl;
+    loadBangDataFromTable(std::move(table), {});
+    return true;
+}
@@ -0,0 +1,337 @@
+#include "../include/http_client.h"
+#include <algorithm>
+#include <cerrno>
+#include <cctype>
+#include <charconv>
+#include <cstring>
+#include <iostream>
+#include <optional>
+
+#include <netdb.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <zlib.h>
+
+namespace {
+    constexpr size_t MAX_HEADER_SIZE = 64 * 1024;
+    constexpr size_t MAX_BODY_SIZE = 256 * 1024 * 1024; // Decoded; the bang list is a few MiB
+
+    struct Url {
+        std::string host;
+        std::string port = "80";
+        std::string path = "/";
+    };
+
+    std::optional<Url> parseUrl(std::string_view url) {
+        if (const size_t schemeEnd = url.find("://"); schemeEnd != std::string_view::npos) {
+            url.remove_prefix(schemeEnd + 3);
+        }
+
+        Url parsed;
+        const size_t pathStart = url.find('/');
+        std::string_view authority = url.substr(0, pathStart);
+        if (pathStart != std::string_view::npos) {
+            parsed.path = url.substr(pathStart);
+        }
+
+        // IPv6 literals are bracketed, so their colons are not mistaken for the port separator
+        size_t hostEnd = authority.size();
+        if (authority.starts_with('[')) {
+            hostEnd = authority.find(']');
+            if (hostEnd == std::string_view::npos) return std::nullopt;
+            parsed.host = authority.substr(1, hostEnd - 1);
+            ++hostEnd;
+        } else {
+            hostEnd = std::min(authority.find(':'), authority.size());
+            parsed.host = authority.substr(0, hostEnd);
+        }
+        if (hostEnd < authority.size()) {
+            if (authority[hostEnd] != ':') return std::nullopt;
+            parsed.port = authority.substr(hostEnd + 1);
+        }
+
+        if (parsed.host.empty() || parsed.port.empty()) return std::nullopt;
+        return parsed;
+    }
+
+    bool waitFor(const int fd, const short events, const std::chrono::milliseconds timeout) {
+        pollfd pfd{fd, events, 0};
+        int ret;
+        while ((ret = poll(&pfd, 1, static_cast<int>(timeout.count()))) < 0 && errno == EINTR) {
+        }
+        return ret > 0;
+    }
+
+    // Non-blocking socket connected to the first address of host that accepts within timeout, -1 if none does
+    int connectTo(const Url &url, const std::chrono::milliseconds timeout) {
+        addrinfo hints{};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+
+        addrinfo *addresses = nullptr;
+        if (const int ret = getaddrinfo(url.host.c_str(), url.port.c_str(), &hints, &addresses); ret != 0) {
+            std::cerr << "Error: Could not resolve hostname " << url.host << ": " << gai_strerror(ret) << std::endl;
+            return -1;
+        }
+
+        int fd = -1;
+        for (const addrinfo *address = addresses; address; address = address->ai_next) {
+            fd = socket(address->ai_family, address->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                        address->ai_protocol);
+            if (fd < 0) continue;
+
+            if (connect(fd, address->ai_addr, address->ai_addrlen) == 0) break;
+            if (errno == EINPROGRESS && waitFor(fd, POLLOUT, timeout)) {
+                int error = 0;
+                socklen_t length = sizeof(error);
+                if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &length) == 0 && error == 0) break;
+            }
+            close(fd);
+            fd = -1;
+        }
+        freeaddrinfo(addresses);
+
+        if (fd < 0) {
+            std::cerr << "Error connecting to " << url.host << ":" << url.port << std::endl;
+        }
+        return fd;
+    }
+
+    bool sendAll(const int fd, std::string_view data, const std::chrono::milliseconds timeout) {
+        while (!data.empty()) {
+            const ssize_t sent = send(fd, data.data(), data.size(), MSG_NOSIGNAL);
+            if (sent > 0) {
+                data.remove_prefix(sent);
+            } else if (sent < 0 && errno == EINTR) {
+            } else if (sent < 0 && errno == EAGAIN && waitFor(fd, POLLOUT, timeout)) {
+            } else {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Appends what arrives next to buffer. Returns the number of bytes, 0 at end of stream and -1 on errors and
+    // timeouts.
+    ssize_t receiveSome(const int fd, std::string &buffer, const std::chrono::milliseconds timeout) {
+        char chunk[16384];
+        while (true) {
+            const ssize_t received = recv(fd, chunk, sizeof(chunk), 0);
+            if (received >= 0) {
+                buffer.append(chunk, received);
+                return received;
+            }
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN || !waitFor(fd, POLLIN, timeout)) return -1;
+        }
+    }
+
+    bool equalsIgnoreCase(const std::string_view a, const std::string_view b) {
+        return std::ranges::equal(a, b, [](const char x, const char y) {
+            return std::tolower(static_cast<unsigned char>(x)) == std::tolower(static_cast<unsigned char>(y));
+        });
+    }
+
+    bool containsToken(const std::string_view value, const std::string_view token) {
+        for (size_t i = 0; i + token.size() <= value.size(); ++i) {
+            if (equalsIgnoreCase(value.substr(i, token.size()), token)) return true;
+        }
+        return false;
+    }
+
+    std::string_view trim(std::string_view value) {
+        while (!value.empty() && (value.front() == ' ' || value.front() == '\t')) value.remove_prefix(1);
+        while (!value.empty() && (value.back() == ' ' || value.back() == '\t')) value.remove_suffix(1);
+        return value;
+    }
+
+    struct ResponseHead {
+        int status = 0;
+        std::optional<size_t> contentLength;
+        bool chunked = false;
+        bool compressed = false; // gzip or deflate content encoding
+        HttpValidators validators;
+    };
+
+    std::optional<ResponseHead> parseHead(const std::string_view head) {
+        ResponseHead parsed;
+
+        size_t lineEnd = head.find("\r\n");
+        const std::string_view statusLine = head.substr(0, lineEnd);
+        if (!statusLine.starts_with("HTTP/1.") || statusLine.size() < 12) return std::nullopt;
+        if (std::from_chars(statusLine.data() + 9, statusLine.data() + 12, parsed.status).ec != std::errc()) {
+            return std::nullopt;
+        }
+
+        while (lineEnd != std::string_view::npos && lineEnd + 2 < head.size()) {
+            const size_t lineStart = lineEnd + 2;
+            lineEnd = head.find("\r\n", lineStart);
+            const std::string_view line = head.substr(lineStart, lineEnd - lineStart);
+            const size_t colon = line.find(':');
+            if (colon == std::string_view::npos) continue;
+
+            const std::string_view name = line.substr(0, colon);
+            const std::string_view value = trim(line.substr(colon + 1));
+            if (equalsIgnoreCase(name, "Content-Length")) {
+                size_t length;
+                if (std::from_chars(value.data(), value.data() + value.size(), length).ec != std::errc()) {
+                    return std::nullopt;
+                }
+                parsed.contentLength = length;
+            } else if (equalsIgnoreCase(name, "Transfer-Encoding")) {
+                parsed.chunked = containsToken(value, "chunked");
+            } else if (equalsIgnoreCase(name, "Content-Encoding")) {
+                parsed.compressed = containsToken(value, "gzip") || containsToken(value, "deflate");
+            } else if (equalsIgnoreCase(name, "ETag")) {
+                parsed.validators.etag = value;
+            } else if (equalsIgnoreCase(name, "Last-Modified")) {
+                parsed.validators.lastModified = value;
+            }
+        }
+        return parsed;
+    }
+
+    // Chunk sizes followed by their data, up to the zero-size chunk; extensions and trailers are skipped
+    std::optional<std::string> decodeChunked(std::string_view raw) {
+        std::string body;
+        while (true) {
+            const size_t lineEnd = raw.find("\r\n");
+            if (lineEnd == std::string_view::npos) return std::nullopt;
+
+            size_t size;
+            const auto [end, ec] = std::from_chars(raw.data(), raw.data() + lineEnd, size, 16);
+            if (ec != std::errc() || end == raw.data()) return std::nullopt;
+            raw.remove_prefix(lineEnd + 2);
+            if (size == 0) return body;
+
+            if (raw.size() < size + 2 || body.size() + size > MAX_BODY_SIZE) return std::nullopt;
+            body.append(raw.data(), size);
+            raw.remove_prefix(size + 2);
+        }
+    }
+
+    // Inflates a gzip or zlib stream, whichever header it has
+    std::optional<std::string> inflateBody(const std::string_view compressed) {
+        z_stream stream{};
+        if (inflateInit2(&stream, 15 + 32) != Z_OK) return std::nullopt;
+
+        std::string body;
+        stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(compressed.data()));
+        stream.avail_in = static_cast<uInt>(compressed.size());
+
+        int ret = Z_OK;
+        while (ret != Z_STREAM_END) {
+            const size_t offset = body.size();
+            body.resize(offset + std::max<size_t>(compressed.size() * 2, 65536));
+            stream.next_out = reinterpret_cast<Bytef *>(body.data() + offset);
+            stream.avail_out = static_cast<uInt>(body.size() - offset);
+
+            ret = inflate(&stream, Z_NO_FLUSH);
+            body.resize(body.size() - stream.avail_out);
+            if ((ret != Z_OK && ret != Z_STREAM_END) || body.size() > MAX_BODY_SIZE ||
+                (ret == Z_OK && stream.avail_in == 0 && stream.avail_out != 0)) {
+                inflateEnd(&stream);
+                return std::nullopt;
+            }
+        }
+        inflateEnd(&stream);
+        return body;
+    }
+
+    std::string buildRequest(const Url &url, const std::string_view accept, const HttpValidators &validators) {
+        std::string request = "GET " + url.path + " HTTP/1.1\r\n";
+        request += "Host: " + (url.host.find(':') != std::string::npos ? "[" + url.host + "]" : url.host);
+        request += url.port != "80" ? ":" + url.port + "\r\n" : "\r\n";
+        request += "User-Agent: BangServer/1.0\r\n";
+        request += "Accept: ";
+        request += accept;
+        request += "\r\nAccept-Encoding: gzip\r\n";
+        if (!validators.etag.empty()) {
+            request += "If-None-Match: " + validators.etag + "\r\n";
+        }
+        if (!validators.lastModified.empty()) {
+            request += "If-Modified-Since: " + validators.lastModified + "\r\n";
+        }
+        request += "Connection: close\r\n\r\n";
+        return request;
+    }
+}
+
+HttpResponse httpGet(const std::string_view url, const std::string_view accept, const HttpValidators &validators,
+                     const std::chrono::milliseconds timeout) {
+    const std::optional<Url> parsedUrl = parseUrl(url);
+    if (!parsedUrl) {
+        std::cerr << "Error: Invalid URL " << url << std::endl;
+        return {};
+    }
+
+    const int fd = connectTo(*parsedUrl, timeout);
+    if (fd < 0) return {};
+
+    if (!sendAll(fd, buildRequest(*parsedUrl, accept, validators), timeout)) {
+        std::cerr << "Error sending HTTP request\n";
+        close(fd);
+        return {};
+    }
+
+    // Read the head first, then as much of the body as it announces, or everything up to the close
+    std::string raw;
+    size_t headEnd;
+    while ((headEnd = raw.find("\r\n\r\n")) == std::string::npos) {
+        if (raw.size() > MAX_HEADER_SIZE || receiveSome(fd, raw, timeout) <= 0) {
+            std::cerr << "Error: Invalid HTTP response format\n";
+            close(fd);
+            return {};
+        }
+    }
+
+    const std::optional<ResponseHead> head = parseHead(std::string_view(raw).substr(0, headEnd));
+    if (!head) {
+        std::cerr << "Error: Invalid HTTP response format\n";
+        close(fd);
+        return {};
+    }
+
+    const size_t bodyStart = headEnd + 4;
+    const bool bodyless = head->status == 304 || head->status == 204 || head->status / 100 == 1;
+    bool complete = bodyless;
+    while (!complete) {
+        if (!head->chunked && head->contentLength && raw.size() - bodyStart >= *head->contentLength) break;
+        if (raw.size() - bodyStart > MAX_BODY_SIZE) break;
+
+        const ssize_t received = receiveSome(fd, raw, timeout);
+        if (received < 0) break;
+        // End of stream only completes a body that was delimited by it; chunked ones are checked when decoding
+        complete = received == 0 && (head->chunked || !head->contentLength);
+    }
+    close(fd);
+
+    complete = complete || (!head->chunked && head->contentLength && raw.size() - bodyStart >= *head->contentLength);
+    if (!complete) {
+        std::cerr << "Error: Incomplete HTTP response from " << parsedUrl->host << std::endl;
+        return {};
+    }
+
+    HttpResponse response;
+    response.status = head->status;
+    response.validators = head->validators;
+    if (bodyless) return response;
+
+    std::string_view body = std::string_view(raw).substr(bodyStart);
+    if (!head->chunked && head->contentLength) {
+        body = body.substr(0, *head->contentLength);
+    }
+
+    std::optional<std::string> decoded = head->chunked ? decodeChunked(body) : std::string(body);
+    if (decoded && head->compressed) {
+        decoded = inflateBody(*decoded);
+    }
+    if (!decoded) {
+        std::cerr << "Error: Could not decode HTTP response body from " << parsedUrl->host << std::endl;
+        return {};
+    }
+
+    response.body = std::move(*decoded);
+    return response;
+}
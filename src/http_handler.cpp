@@ -1,11 +1,6 @@
 #include "../include/http_handler.h"
 #include "../include/url_processing.h"
 #include <cstring>
-#include <netdb.h>
-#include <sys/socket.h>
-#include <netinet/in.h>
-#include <unistd.h>
-#include <iostream>
 
 const std::string_view HOME_PAGE_HTML = R"(<!DOCTYPE html>
 <html lang="en">
@@ -38,9 +33,9 @@ const std::string_view OPENSEARCH_XML = R"(<?xml version="1.0" encoding="UTF-8"?
 </OpenSearchDescription>)";
 
 std::string_view createHttpResponse(const HttpStatus status, const std::string_view contentType,
-                                    const std::string_view body, char *buffer) {
+                                    const std::string_view body, char *buffer, const bool keepAlive) {
     char *ptr = buffer;
-    std::string statusLine;
+    std::string_view statusLine;
 
     switch (status) {
         case HttpStatus::OK:
@@ -52,6 +47,15 @@ std::string_view createHttpResponse(const HttpStatus status, const std::string_v
         case HttpStatus::NOT_FOUND:
             statusLine = "HTTP/1.1 404 Not Found\r\n";
             break;
+        case HttpStatus::URI_TOO_LONG:
+            statusLine = "HTTP/1.1 414 URI Too Long\r\n";
+            break;
+        case HttpStatus::REQUEST_HEADER_FIELDS_TOO_LARGE:
+            statusLine = "HTTP/1.1 431 Request Header Fields Too Large\r\n";
+            break;
+        case HttpStatus::SERVICE_UNAVAILABLE:
+            statusLine = "HTTP/1.1 503 Service Unavailable\r\n";
+            break;
         default:
             statusLine = "HTTP/1.1 200 OK\r\n";
     }
@@ -84,8 +88,9 @@ std::string_view createHttpResponse(const HttpStatus status, const std::string_v
     ptr += 2;
 
     // End headers
-    memcpy(ptr, "Connection: close\r\n\r\n", 21);
-    ptr += 21;
+    const std::string_view connectionHeader = keepAlive ? CONNECTION_KEEP_ALIVE : CONNECTION_CLOSE;
+    memcpy(ptr, connectionHeader.data(), connectionHeader.size());
+    ptr += connectionHeader.size();
 
     // Write body
     memcpy(ptr, body.data(), body.size());
@@ -94,173 +99,58 @@ std::string_view createHttpResponse(const HttpStatus status, const std::string_v
     return {buffer, static_cast<std::string_view::size_type>(ptr - buffer)};
 }
 
-// Create redirect response (specialized for our use case)
-std::string_view createRedirectResponse(const std::string_view searchUrl, const std::string_view encodedQuery,
-                                        char *buffer) {
-    char *ptr = buffer;
+constexpr std::string_view REDIRECT_HEADER = "HTTP/1.1 302 Found\r\nLocation: ";
+constexpr std::string_view REDIRECT_FOOTER = "\r\nContent-Length: 0\r\n";
 
-    constexpr std::string_view header = "HTTP/1.1 302 Found\r\nLocation: ";
-    constexpr std::string_view footer = "\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+RedirectTemplate compileRedirectTemplate(const std::string_view searchUrl) {
     constexpr std::string_view placeholder = "{{{s}}}";
-    memcpy(ptr, header.data(), header.size());
-    ptr += header.size();
-
-    const auto placeholderPos = static_cast<const char *>(memmem(searchUrl.data(), searchUrl.size(),
-                                                                 placeholder.data(), placeholder.size()));
 
-    if (placeholderPos) {
-        const size_t beforeLen = placeholderPos - searchUrl.data();
-        memcpy(ptr, searchUrl.data(), beforeLen);
-        ptr += beforeLen;
-        memcpy(ptr, encodedQuery.data(), encodedQuery.size());
-        ptr += encodedQuery.size();
-        const size_t afterLen = searchUrl.size() - beforeLen - placeholder.size();
-        memcpy(ptr, placeholderPos + placeholder.size(), afterLen);
-        ptr += afterLen;
+    RedirectTemplate redirect;
+    redirect.head = REDIRECT_HEADER;
+    if (const size_t placeholderPos = searchUrl.find(placeholder); placeholderPos != std::string_view::npos) {
+        redirect.head += searchUrl.substr(0, placeholderPos);
+        redirect.tail = searchUrl.substr(placeholderPos + placeholder.size());
     } else {
-        // Append encoded query to searchUrl
-        memcpy(ptr, searchUrl.data(), searchUrl.size());
-        ptr += searchUrl.size();
-        memcpy(ptr, encodedQuery.data(), encodedQuery.size());
-        ptr += encodedQuery.size();
+        redirect.head += searchUrl;
     }
-
-    // Copy footer
-    memcpy(ptr, footer.data(), footer.size());
-    ptr += footer.size();
-
-    return {buffer, static_cast<std::string_view::size_type>(ptr - buffer)};
+    redirect.tail += REDIRECT_FOOTER;
+    return redirect;
 }
 
-std::string_view extractPath(const std::string_view requestData) {
-    const char *data = requestData.data();
-    const size_t size = requestData.size();
-
-    // Find first space after HTTP method
-    const char *urlStart = nullptr;
-    for (const char *p = data; p < data + size - 1; p++) {
-        if (*p == ' ') {
-            urlStart = p + 1;
-            break;
-        }
-    }
-
-    if (!urlStart) return "/"; // Default to root path if no URL found
-
-    // Find second space (after URL)
-    const char *urlEnd = nullptr;
-    for (const char *p = urlStart; p < data + size - 1; p++) {
-        if (*p == ' ') {
-            urlEnd = p;
-            break;
-        }
-        // Early termination if we hit the end of line
-        if (*p == '\r' && *(p + 1) == '\n') {
-            urlEnd = p;
-            break;
-        }
-    }
-
-    if (!urlEnd) return "/"; // Default to root path if URL end not found
-
-    // Check for query string and strip it
-    const char *queryStart = nullptr;
-    for (const char *p = urlStart; p < urlEnd; p++) {
-        if (*p == '?') {
-            queryStart = p;
-            break;
-        }
-    }
-
-    if (queryStart) {
-        return {urlStart, static_cast<size_t>(queryStart - urlStart)};
-    }
-
-    return {urlStart, static_cast<size_t>(urlEnd - urlStart)};
+RedirectTemplate renderFixedRedirect(const std::string_view url) {
+    RedirectTemplate redirect = compileRedirectTemplate(url);
+    redirect.head += redirect.tail;
+    redirect.tail.clear();
+    return redirect;
 }
 
-// Blocking for now
-std::string makeHttpRequest(const std::string &url, const std::string &acceptType) {
-    const int socFd = socket(AF_INET, SOCK_STREAM, 0);
-    if (socFd < 0) {
-        std::cerr << "Error creating socket\n";
-        return "";
-    }
-
-    std::string hostname;
-    std::string path;
-
-    size_t hostStart = url.find("://");
-    if (hostStart != std::string::npos) {
-        hostStart += 3; // Skip "://"
-    } else {
-        hostStart = 0;
-    }
-
-    if (const size_t pathStart = url.find('/', hostStart); pathStart != std::string::npos) {
-        hostname = url.substr(hostStart, pathStart - hostStart);
-        path = url.substr(pathStart);
-    } else {
-        hostname = url.substr(hostStart);
-        path = "/";
-    }
-
-    // Resolve hostname
-    const hostent *server = gethostbyname(hostname.c_str());
-    if (server == nullptr) {
-        std::cerr << "Error: Could not resolve hostname " << hostname << std::endl;
-        close(socFd);
-        return "";
-    }
-
-    // Set up connection
-    sockaddr_in serverAddr{};
-    std::memset(&serverAddr, 0, sizeof(serverAddr));
-    serverAddr.sin_family = AF_INET;
-    std::memcpy(&serverAddr.sin_addr.s_addr, server->h_addr, server->h_length);
-    serverAddr.sin_port = htons(80);
-
-    if (connect(socFd, reinterpret_cast<sockaddr *>(&serverAddr), sizeof(serverAddr)) < 0) {
-        std::cerr << "Error connecting to server\n";
-        close(socFd);
-        return "";
-    }
-
-    std::string request = "GET " + path + " HTTP/1.1\r\n";
-    request += "Host: " + hostname + "\r\n";
-    request += "User-Agent: BangServer/1.0\r\n";
-    request += "Accept: " + acceptType + "\r\n";
-    request += "Connection: close\r\n\r\n";
-
-    if (send(socFd, request.c_str(), request.length(), 0) < 0) {
-        std::cerr << "Error sending HTTP request\n";
-        close(socFd);
-        return "";
-    }
-
-    // Receive response
-    std::string response;
-    char buffer[4096];
-    ssize_t bytesRead;
+std::string_view createRedirectResponse(const RedirectTemplate &redirect, const std::string_view encodedQuery,
+                                        char *buffer, const bool keepAlive) {
+    char *ptr = buffer;
 
-    while ((bytesRead = recv(socFd, buffer, sizeof(buffer) - 1, 0)) > 0) {
-        buffer[bytesRead] = '\0';
-        response += buffer;
-    }
+    memcpy(ptr, redirect.head.data(), redirect.head.size());
+    ptr += redirect.head.size();
+    memcpy(ptr, encodedQuery.data(), encodedQuery.size());
+    ptr += encodedQuery.size();
+    memcpy(ptr, redirect.tail.data(), redirect.tail.size());
+    ptr += redirect.tail.size();
 
-    close(socFd);
+    const std::string_view connectionHeader = keepAlive ? CONNECTION_KEEP_ALIVE : CONNECTION_CLOSE;
+    memcpy(ptr, connectionHeader.data(), connectionHeader.size());
+    ptr += connectionHeader.size();
 
-    if (response.empty()) {
-        std::cerr << "Error: Empty response from server\n";
-        return "";
-    }
+    return {buffer, static_cast<std::string_view::size_type>(ptr - buffer)};
+}
 
-    // Extract response body
-    const size_t bodyStart = response.find("\r\n\r\n");
-    if (bodyStart == std::string::npos) {
-        std::cerr << "Error: Invalid HTTP response format\n";
-        return "";
-    }
+size_t maxHttpResponseSize(const std::string_view contentType, const std::string_view body) {
+    // Longest status line, both headers with a 20-digit length, and the longer connection header
+    constexpr size_t fixedSize = std::string_view("HTTP/1.1 431 Request Header Fields Too Large\r\n").size() +
+                                 std::string_view("Content-Type: \r\n").size() +
+                                 std::string_view("Content-Length: \r\n").size() + 20 +
+                                 CONNECTION_KEEP_ALIVE.size();
+    return fixedSize + contentType.size() + body.size();
+}
 
-    return response.substr(bodyStart + 4);
+size_t maxRedirectResponseSize(const RedirectTemplate &redirect, const std::string_view encodedQuery) {
+    return redirect.head.size() + encodedQuery.size() + redirect.tail.size() + CONNECTION_KEEP_ALIVE.size();
 }
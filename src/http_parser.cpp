@@ -0,0 +1,120 @@
+#include "../include/http_parser.h"
+#include "../include/cpu_dispatch.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <strings.h>
+
+#ifdef __x86_64__
+#include <immintrin.h>
+#endif
+
+static std::string_view trimWhitespace(std::string_view value) {
+    while (!value.empty() && (value.front() == ' ' || value.front() == '\t')) value.remove_prefix(1);
+    while (!value.empty() && (value.back() == ' ' || value.back() == '\t')) value.remove_suffix(1);
+    return value;
+}
+
+static bool equalsIgnoreCase(const std::string_view name, const std::string_view expected) {
+    return name.size() == expected.size() && strncasecmp(name.data(), expected.data(), expected.size()) == 0;
+}
+
+// Files the header into the request if it is one we care about; the length check rules out almost every other header
+static void storeHeader(HttpRequest &request, const std::string_view name, const std::string_view value) {
+    switch (name.size()) {
+        case 4:
+            if (equalsIgnoreCase(name, "host")) request.host = value;
+            break;
+        case 10:
+            if (equalsIgnoreCase(name, "connection")) request.connection = value;
+            break;
+        case 13:
+            if (equalsIgnoreCase(name, "if-none-match")) request.ifNoneMatch = value;
+            break;
+        case 15:
+            if (equalsIgnoreCase(name, "accept-encoding")) request.acceptEncoding = value;
+            break;
+        default:
+            break;
+    }
+}
+
+// The parser in http_parser_kernels.inc is compiled once per SimdTier, like the URL kernels, and the copy for the
+// active tier is called through PARSER_KERNELS
+namespace scalar_parser {
+#define HTTP_PARSER_TIER SIMD_TIER_SCALAR
+#include "http_parser_kernels.inc"
+#undef HTTP_PARSER_TIER
+}
+
+#ifdef __x86_64__
+SIMD_TARGET(SIMD_ISA_SSE42)
+namespace sse42_parser {
+#define HTTP_PARSER_TIER SIMD_TIER_SSE42
+#include "http_parser_kernels.inc"
+#undef HTTP_PARSER_TIER
+}
+SIMD_TARGET_END
+
+SIMD_TARGET(SIMD_ISA_AVX2)
+namespace avx2_parser {
+#define HTTP_PARSER_TIER SIMD_TIER_AVX2
+#include "http_parser_kernels.inc"
+#undef HTTP_PARSER_TIER
+}
+SIMD_TARGET_END
+#endif
+
+namespace {
+    struct ParserKernels {
+        size_t (*parseHttpRequest)(std::string_view, HttpRequest &);
+        size_t (*findHeadersEnd)(std::string_view, size_t);
+    };
+
+#define PARSER_KERNELS_OF(tier) ParserKernels{tier::parseHttpRequest, tier::findHeadersEnd}
+
+    // Indexed by SimdTier. Request lines and headers are too short for 64-byte vectors to pay off, so the AVX-512
+    // tier runs the AVX2 parser.
+    constexpr ParserKernels PARSER_KERNELS[] = {
+        PARSER_KERNELS_OF(scalar_parser),
+#ifdef __x86_64__
+        PARSER_KERNELS_OF(sse42_parser),
+        PARSER_KERNELS_OF(avx2_parser),
+        PARSER_KERNELS_OF(avx2_parser),
+#endif
+    };
+
+    const ParserKernels &kernels() {
+        return PARSER_KERNELS[static_cast<int>(activeSimdTier())];
+    }
+}
+
+size_t parseHttpRequest(const std::string_view data, HttpRequest &request) {
+    return kernels().parseHttpRequest(data, request);
+}
+
+size_t findHeadersEnd(const std::string_view data, const size_t from) {
+    return kernels().findHeadersEnd(data, from);
+}
+
+// Case-insensitive search for a comma-separated token in a header value, e.g. "keep-alive, Upgrade"
+static bool headerHasToken(std::string_view value, const std::string_view token) {
+    while (!value.empty()) {
+        const size_t comma = value.find(',');
+
+        if (equalsIgnoreCase(trimWhitespace(value.substr(0, comma)), token)) {
+            return true;
+        }
+
+        if (comma == std::string_view::npos) break;
+        value.remove_prefix(comma + 1);
+    }
+    return false;
+}
+
+bool isKeepAlive(const HttpRequest &request) {
+    // HTTP/1.1 defaults to persistent connections, HTTP/1.0 (and anything older) to close
+    if (headerHasToken(request.connection, "close")) return false;
+    if (headerHasToken(request.connection, "keep-alive")) return true;
+    return request.version == "HTTP/1.1";
+}